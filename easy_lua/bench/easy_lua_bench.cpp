@@ -0,0 +1,354 @@
+#include "easy_lua.hpp"
+#include "easy_lua_buffer.hpp"
+#include "easy_lua_bytecode_cache.hpp"
+#include "easy_lua_ffi.hpp"
+#include "easy_lua_function_ref.hpp"
+#include "easy_lua_profiler.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
+
+namespace {
+    std::atomic<uint64_t> heap_allocations{ 0 };
+    /// Lua allocator requests of states created and closed inside a benchmark.
+    std::atomic<uint64_t> closed_state_allocations{ 0 };
+
+    struct BenchResult
+    {
+        /// <summary>
+        /// Nanoseconds per operation.
+        /// </summary>
+        double ns_per_op;
+        /// <summary>
+        /// C++ heap allocations per operation.
+        /// </summary>
+        double heap_per_op;
+        /// <summary>
+        /// Lua allocator requests per operation.
+        /// </summary>
+        double lua_per_op;
+    };
+
+    const char* filter = nullptr;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Runs 'callback' until at least 'min_time' passed and reports the per operation cost. The
+    /// callback performs 'batch' operations per invocation. Lua allocations are read from the
+    /// tracking allocator of 'lua' if one is given, else from closed_state_allocations.
+    /// </summary>
+    ///-------------------------------------------------------------------------------------------------
+    template<typename F>
+    void bench(
+        const char*     name,
+        const easy_lua* lua,
+        const uint64_t  batch,
+        F&&             callback )
+    {
+        using clock = std::chrono::steady_clock;
+        if( filter && !std::strstr( name, filter ) ) {
+            return;
+        }
+
+        /// warm up caches and the JIT
+        for( auto i = 0; i < 3; ++i ) {
+            callback();
+        }
+
+        constexpr auto min_time   = std::chrono::milliseconds( 300 );
+        uint64_t       operations = 0;
+        const auto     heap_start = heap_allocations.load();
+        const auto     lua_start  = lua ? lua->memory_stats().allocations : closed_state_allocations.load();
+        const auto     start      = clock::now();
+        auto           elapsed    = clock::duration::zero();
+        do {
+            callback();
+            operations += batch;
+            elapsed     = clock::now() - start;
+        } while( elapsed < min_time );
+
+        const auto ns = static_cast<double>( std::chrono::duration_cast<std::chrono::nanoseconds>( elapsed ).count() );
+        const BenchResult result{
+            ns / static_cast<double>( operations ),
+            static_cast<double>( heap_allocations.load() - heap_start ) / static_cast<double>( operations ),
+            static_cast<double>( ( lua ? lua->memory_stats().allocations : closed_state_allocations.load() ) - lua_start ) / static_cast<double>( operations )
+        };
+        printf( "%-40s %12.1f ns/op %10.3f new/op %10.3f lua-alloc/op\n", name, result.ns_per_op, result.heap_per_op, result.lua_per_op );
+    }
+
+    struct BenchObject
+    {
+        int32_t value = 42;
+    };
+
+    EASY_LUA_CREATE_METATABLE_DATA( BenchObject );
+
+    easy_lua* create_state()
+    {
+        const auto lua = easy_lua::initialize( "", easy_lua::Allocator_Tracking );
+        if( !lua ) {
+            printf( "failed to create a lua state\n" );
+            std::exit( 1 );
+        }
+        return lua;
+    }
+
+    void bench_cpp_to_lua( easy_lua* lua )
+    {
+        lua->execute( "function bench_add( a, b ) return a + b end", true );
+        bench( "cpp_to_lua/get_global+pcall", lua, 1, [ lua ]()
+        {
+            lua->get_global( "bench_add" );
+            lua->push_number( 1 );
+            lua->push_number( 2 );
+            lua->pcall( 2, 1, 0 );
+            lua->get_number( -1, 0.0, true );
+        } );
+
+        easy_lua_function_ref<double( double, double )> add( lua, "bench_add" );
+        bench( "cpp_to_lua/function_ref", lua, 1, [ &add ]()
+        {
+            add( 1.0, 2.0 );
+        } );
+
+        constexpr size_t                        items = 1000;
+        std::vector<std::tuple<double, double>> inputs( items, std::make_tuple( 1.0, 2.0 ) );
+        std::vector<easy_lua_result<double>>    outputs( items );
+        bench( "cpp_to_lua/call_batch", lua, items, [ lua, &inputs, &outputs ]()
+        {
+            lua->call_batch( "bench_add", inputs, outputs );
+        } );
+    }
+
+    double bench_native_add(
+        const double a,
+        const double b )
+    {
+        return a + b;
+    }
+
+    void bench_lua_to_cpp( easy_lua* lua )
+    {
+        constexpr uint64_t calls = 100000;
+        lua->export_function( "bench_native_classic", []( easy_lua* l ) -> int32_t
+        {
+            if( !l->is_number( 1 ) || !l->is_number( 2 ) ) {
+                return 0;
+            }
+            l->push_number( l->get_number( 1 ) + l->get_number( 2 ) );
+            return l->pushed();
+        } );
+        lua->export_function( "bench_native_typed", []( const double a, const double b )
+        {
+            return a + b;
+        } );
+        /// falls back to the typed binding without the ffi module
+        easy_lua_ffi::export_function<&bench_native_add>( lua, "bench_native_ffi" );
+        lua->execute(
+            "function bench_call_classic( n ) local f = bench_native_classic for i = 1, n do f( i, 1 ) end end "
+            "function bench_call_typed( n ) local f = bench_native_typed for i = 1, n do f( i, 1 ) end end "
+            "function bench_call_ffi( n ) local f = bench_native_ffi for i = 1, n do f( i, 1 ) end end",
+            true
+        );
+
+        for( const auto name : { "bench_call_classic", "bench_call_typed", "bench_call_ffi" } ) {
+            const auto label = std::string( "lua_to_cpp/" ) + ( name + 11 );
+            bench( label.c_str(), lua, calls, [ lua, name ]()
+            {
+                lua->get_global( name );
+                lua->push_number( calls );
+                lua->pcall( 1, 0, 0 );
+            } );
+        }
+    }
+
+    void bench_userdata( easy_lua* lua )
+    {
+        lua->export_class( lua_BenchObject, { { "noop", []( easy_lua* ) -> int32_t { return 0; } } } );
+        BenchObject object;
+        bench( "userdata/push+get (name)", lua, 1, [ lua, &object ]()
+        {
+            lua->push_userdata( lua_BenchObject[ 1 ], &object );
+            lua->get_userdata<BenchObject>( -1, lua_BenchObject[ 1 ], true );
+        } );
+        bench( "userdata/push+get (handle)", lua, 1, [ lua, &object ]()
+        {
+            lua->push_userdata( lua_BenchObject, &object );
+            lua->get_userdata<BenchObject>( -1, lua_BenchObject, true );
+        } );
+        lua_gc( EASY_LUA_CAST_LUA( lua ), LUA_GCCOLLECT, 0 );
+    }
+
+    void bench_strings( easy_lua* lua )
+    {
+        for( const size_t size : { 16, 256, 4096, 65536 } ) {
+            std::string payload( size, 'x' );
+            /// distinct strings, interning a repeated string only costs a hash
+            size_t round = 0;
+            const auto label = "string/push+get " + std::to_string( size );
+            bench( label.c_str(), lua, 1, [ lua, &payload, &round ]()
+            {
+                payload[ round++ % payload.size() ] ^= 1;
+                lua->push_string( payload );
+                lua->get_string_view( -1 );
+                lua->pop( 1 );
+            } );
+            lua_gc( EASY_LUA_CAST_LUA( lua ), LUA_GCCOLLECT, 0 );
+
+            const easy_lua_buffer::Owner owner;
+            const auto view_label = "buffer/push+get " + std::to_string( size );
+            bench( view_label.c_str(), lua, 1, [ lua, &payload, &owner ]()
+            {
+                size_t length = 0;
+                easy_lua_buffer::push( lua, payload.data(), payload.size(), owner );
+                easy_lua_buffer::get( lua, -1, length );
+                lua->pop( 1 );
+            } );
+            lua_gc( EASY_LUA_CAST_LUA( lua ), LUA_GCCOLLECT, 0 );
+        }
+    }
+
+    void bench_tables( easy_lua* lua )
+    {
+        for( const size_t size : { 16, 1024, 100000 } ) {
+            std::vector<double> values( size, 1.5 );
+            std::vector<double> result;
+            const auto label = "table/push+get_table " + std::to_string( size );
+            bench( label.c_str(), lua, 1, [ lua, &values, &result ]()
+            {
+                lua->push_table( values );
+                lua->get_table( -1, result, true );
+            } );
+            lua_gc( EASY_LUA_CAST_LUA( lua ), LUA_GCCOLLECT, 0 );
+        }
+    }
+
+    void bench_profiler( easy_lua* lua )
+    {
+        constexpr uint64_t iterations = 100000;
+        lua->execute(
+            "function bench_profiled( n ) local t = {} for i = 1, n do t[ i % 64 + 1 ] = tostring( i ) end end",
+            true
+        );
+
+        easy_lua_profiler profiler( lua );
+        for( const auto enabled : { false, true } ) {
+            if( enabled && !profiler.start() ) {
+                continue;
+            }
+            const auto label = std::string( "profiler/loop " ) + ( enabled ? "(sampling)" : "(off)" );
+            bench( label.c_str(), lua, iterations, [ lua ]()
+            {
+                lua->get_global( "bench_profiled" );
+                lua->push_number( iterations );
+                lua->pcall( 1, 0, 0 );
+            } );
+        }
+        profiler.stop();
+    }
+
+    void bench_include()
+    {
+        const auto directory = std::filesystem::temp_directory_path() / "easy_lua_bench";
+        std::filesystem::create_directories( directory );
+        const auto module = directory / "module.lua";
+        {
+            std::ofstream stream( module );
+            for( auto i = 0; i < 200; ++i ) {
+                stream << "function module_fn_" << i << "( a, b )\n"
+                       << "    local t = { a, b, " << i << " }\n"
+                       << "    return t[ 1 ] + t[ 2 ] * t[ 3 ]\n"
+                       << "end\n";
+            }
+        }
+
+        auto lua = easy_lua::initialize( directory.string(), easy_lua::Allocator_Tracking );
+        if( !lua ) {
+            printf( "include: failed to create a lua state\n" );
+            std::filesystem::remove_all( directory );
+            return;
+        }
+        for( const auto cached : { false, true } ) {
+            easy_lua_bytecode_cache::shared()->set_enabled( cached );
+            const auto label = std::string( "include/200 functions " ) + ( cached ? "(cached)" : "(parse)" );
+            bench( label.c_str(), lua, 1, [ lua ]()
+            {
+                lua->get_global( "include" );
+                lua->push_string( "module.lua" );
+                lua->pcall( 1, 0, 0 );
+            } );
+        }
+        easy_lua_bytecode_cache::shared()->set_enabled( true );
+        easy_lua::close( &lua );
+        std::filesystem::remove_all( directory );
+    }
+
+    void bench_initialize()
+    {
+        /// The default allocator can not be counted, the tracking allocator forwards to it. The
+        /// blocks luaL_newstate allocates before the tracker is attached are missing from the count.
+        for( const auto& [ label, allocator ] : {
+            std::make_pair( "initialize/default (tracked)", easy_lua::Allocator_Tracking ),
+            std::make_pair( "initialize/size_class", easy_lua::Allocator_SizeClass ),
+            std::make_pair( "initialize/arena", easy_lua::Allocator_Arena ) } ) {
+            bench( label, nullptr, 1, [ allocator = allocator ]()
+            {
+                auto lua = easy_lua::initialize( "", allocator );
+                if( lua ) {
+                    closed_state_allocations += lua->memory_stats().allocations;
+                }
+                easy_lua::close( &lua );
+            } );
+        }
+    }
+}
+
+void* operator new(
+    const size_t size )
+{
+    ++heap_allocations;
+    if( const auto block = std::malloc( size ? size : 1 ) ) {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(
+    void* block ) noexcept
+{
+    std::free( block );
+}
+
+void operator delete(
+    void*  block,
+    size_t ) noexcept
+{
+    std::free( block );
+}
+
+int main(
+    const int argc,
+    char**    argv )
+{
+    if( argc > 1 ) {
+        filter = argv[ 1 ];
+    }
+
+    auto lua = create_state();
+    bench_cpp_to_lua( lua );
+    bench_lua_to_cpp( lua );
+    bench_userdata( lua );
+    bench_strings( lua );
+    bench_tables( lua );
+    bench_profiler( lua );
+    easy_lua::close( &lua );
+
+    bench_include();
+    bench_initialize();
+    return 0;
+}
@@ -1,47 +1,561 @@
 #include "easy_lua.hpp"
+#include "easy_lua_allocator.hpp"
+#include "easy_lua_bytecode_cache.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <unordered_map>
+
+namespace {
+    /// The address of this variable is the registry key of the state allocator.
+    char allocator_key = 0;
+    /// The address of this variable is the registry key of the state context.
+    char context_key = 0;
+    /// The address of this variable is the registry key of the JIT helpers of a state.
+    char jit_key = 0;
+    /// The address of this variable is the registry key of the binding instrumentation wrapper.
+    char instrument_key = 0;
+
+    /// Evaluates to false without the jit module. Trace events are counted in 'stats', aborts
+    /// as stats.aborts[ reason ][ location ]. The reason texts need jit.vmdef, without it only
+    /// the error code is known.
+    constexpr char jit_source[] =
+        "local ok, jit = pcall( require, 'jit' )\n"
+        "if not ok then return false end\n"
+        "local util = require( 'jit.util' )\n"
+        "local has_vmdef, vmdef = pcall( require, 'jit.vmdef' )\n"
+        "local format = string.format\n"
+        "local stats = { started = 0, compiled = 0, aborted = 0, flushed = 0, aborts = {} }\n"
+        "local function reason( code, info )\n"
+        "    local text = has_vmdef and vmdef.traceerr[ code ]\n"
+        "    if not text then return 'error ' .. tostring( code ) end\n"
+        "    local formatted, message = pcall( format, text, info )\n"
+        "    return formatted and message or text\n"
+        "end\n"
+        "local function location( func, pc )\n"
+        "    local found, info = pcall( util.funcinfo, func, pc )\n"
+        "    return found and ( info.loc or info.source ) or '?'\n"
+        "end\n"
+        "local function handler( what, tr, func, pc, code, info )\n"
+        "    if what == 'start' then stats.started = stats.started + 1\n"
+        "    elseif what == 'stop' then stats.compiled = stats.compiled + 1\n"
+        "    elseif what == 'flush' then stats.flushed = stats.flushed + 1\n"
+        "    elseif what == 'abort' then\n"
+        "        stats.aborted = stats.aborted + 1\n"
+        "        local text = reason( code, info )\n"
+        "        local where = location( func, pc )\n"
+        "        local by_reason = stats.aborts[ text ]\n"
+        "        if not by_reason then by_reason = {} stats.aborts[ text ] = by_reason end\n"
+        "        by_reason[ where ] = ( by_reason[ where ] or 0 ) + 1\n"
+        "    end\n"
+        "end\n"
+        "return {\n"
+        "    stats = stats,\n"
+        "    attach = function( enable )\n"
+        "        if enable then jit.attach( handler, 'trace' ) else jit.attach( handler ) end\n"
+        "    end,\n"
+        "    reset = function()\n"
+        "        stats.started, stats.compiled, stats.aborted, stats.flushed = 0, 0, 0, 0\n"
+        "        stats.aborts = {}\n"
+        "    end,\n"
+        "    options = function( ... ) require( 'jit.opt' ).start( ... ) end,\n"
+        "}\n";
+
+    /// Latencies of an instrumented binding. Each power of two is split into four buckets, a
+    /// percentile is reported as the upper bound of its bucket.
+    struct Binding
+    {
+        static constexpr size_t bucket_count = 256;
+
+        uint64_t                             calls    = 0;
+        uint64_t                             errors   = 0;
+        uint64_t                             total_ns = 0;
+        uint64_t                             max_ns   = 0;
+        std::array<uint64_t, bucket_count>   buckets  = {};
+
+        static size_t bucket(
+            const uint64_t ns )
+        {
+            if( ns < 4 ) {
+                return static_cast<size_t>( ns );
+            }
+            size_t msb = 0;
+            for( size_t shift = 32; shift != 0; shift /= 2 ) {
+                if( ns >> ( msb + shift ) ) {
+                    msb += shift;
+                }
+            }
+            return ( msb - 1 ) * 4 + static_cast<size_t>( ( ns >> ( msb - 2 ) ) & 3 );
+        }
+
+        static uint64_t upper_bound(
+            const size_t index )
+        {
+            if( index < 4 ) {
+                return index;
+            }
+            const auto msb   = index / 4 + 1;
+            const auto lower = static_cast<uint64_t>( 4 + index % 4 ) << ( msb - 2 );
+            return lower + ( uint64_t( 1 ) << ( msb - 2 ) ) - 1;
+        }
+
+        void record(
+            const uint64_t ns,
+            const bool     failed )
+        {
+            ++calls;
+            errors   += failed ? 1 : 0;
+            total_ns += ns;
+            max_ns    = std::max( max_ns, ns );
+            ++buckets[ bucket( ns ) ];
+        }
+
+        uint64_t percentile(
+            const double fraction ) const
+        {
+            const auto rank = static_cast<uint64_t>( fraction * static_cast<double>( calls - 1 ) ) + 1;
+            uint64_t   seen = 0;
+            for( size_t i = 0; i < bucket_count; ++i ) {
+                seen += buckets[ i ];
+                if( seen >= rank ) {
+                    return std::min( upper_bound( i ), max_ns );
+                }
+            }
+            return max_ns;
+        }
+    };
+
+    struct BudgetScope;
+
+    /// Per state data, a full userdata in the registry which is destroyed by lua_close.
+    struct Context
+    {
+        explicit Context(
+            const easy_lua::Config& config )
+            : config( config )
+        {
+        }
+
+        easy_lua::Config                         config;
+        std::shared_ptr<char>                    lifetime = std::make_shared<char>( 0 );
+        /// Node based, instrumented closures keep a pointer to their entry.
+        std::unordered_map<std::string, Binding> bindings;
+        easy_lua::GcPolicy                       gc_policy;
+        easy_lua::GcStats                        gc_stats;
+        bool                                     memory_stats_exported = false;
+        /// The innermost budgeted pcall of the state and its coroutines.
+        BudgetScope*                             active_budget = nullptr;
+    };
+
+    /// The current state of the thread, states without a context can not be validated.
+    thread_local easy_lua*           current_lua     = nullptr;
+    thread_local bool                current_tracked = false;
+    thread_local std::weak_ptr<void> current_lifetime;
+
+    Context* get_context(
+        lua_State* l )
+    {
+        lua_pushlightuserdata( l, &context_key );
+        lua_rawget( l, LUA_REGISTRYINDEX );
+        const auto context = static_cast<Context*>( lua_touserdata( l, -1 ) );
+        lua_pop( l, 1 );
+        return context;
+    }
+
+    /// Pushes the JIT helper 'name', nothing if the jit module is not available.
+    bool push_jit_helper(
+        lua_State*  l,
+        const char* name )
+    {
+        lua_pushlightuserdata( l, &jit_key );
+        lua_rawget( l, LUA_REGISTRYINDEX );
+        if( lua_isnil( l, -1 ) ) {
+            lua_pop( l, 1 );
+            if( luaL_loadbuffer( l, jit_source, sizeof( jit_source ) - 1, "=easy_lua_jit" ) != 0
+             || lua_pcall( l, 0, 1, 0 ) != 0 ) {
+                lua_pop( l, 1 );
+                lua_pushboolean( l, 0 );
+            }
+            lua_pushlightuserdata( l, &jit_key );
+            lua_pushvalue( l, -2 );
+            lua_rawset( l, LUA_REGISTRYINDEX );
+        }
+        if( !lua_istable( l, -1 ) ) {
+            lua_pop( l, 1 );
+            return false;
+        }
+        lua_getfield( l, -1, name );
+        lua_remove( l, -2 );
+        return true;
+    }
+
+    /// Upvalue 1 is the original function, upvalue 2 its Binding.
+    /// Nanoseconds on the steady clock, as number for the instrumentation wrapper.
+    int instrumented_clock(
+        lua_State* l )
+    {
+        const auto now = std::chrono::steady_clock::now().time_since_epoch();
+        lua_pushnumber( l, static_cast<lua_Number>( std::chrono::duration_cast<std::chrono::nanoseconds>( now ).count() ) );
+        return 1;
+    }
+
+    /// Called with binding, start, pcall status and results. Records the call and returns the
+    /// results or raises the error again.
+    int instrumented_finish(
+        lua_State* l )
+    {
+        const auto now     = std::chrono::steady_clock::now().time_since_epoch();
+        const auto binding = static_cast<Binding*>( lua_touserdata( l, 1 ) );
+        const auto elapsed = static_cast<lua_Number>( std::chrono::duration_cast<std::chrono::nanoseconds>( now ).count() )
+                           - lua_tonumber( l, 2 );
+        const auto failed  = lua_toboolean( l, 3 ) == 0;
+        binding->record( elapsed > 0 ? static_cast<uint64_t>( elapsed ) : 0, failed );
+        if( failed ) {
+            lua_settop( l, 4 );
+            return lua_error( l );
+        }
+        return lua_gettop( l ) - 3;
+    }
+
+    /// The wrapper is written in lua, a C function calling the binding would stop it from
+    /// yielding while LuaJIT yields across pcall. Time a binding spends suspended is part of
+    /// its call.
+    constexpr char instrument_source[] =
+        "local clock, finish, pcall = ...\n"
+        "return function( f, binding )\n"
+        "    return function( ... )\n"
+        "        return finish( binding, clock(), pcall( f, ... ) )\n"
+        "    end\n"
+        "end\n";
+
+    /// Pushes the function creating instrumented wrappers, nothing if it can not be loaded.
+    bool push_instrument_wrapper(
+        lua_State* l )
+    {
+        lua_pushlightuserdata( l, &instrument_key );
+        lua_rawget( l, LUA_REGISTRYINDEX );
+        if( lua_isnil( l, -1 ) ) {
+            lua_pop( l, 1 );
+            if( luaL_loadbuffer( l, instrument_source, sizeof( instrument_source ) - 1, "=easy_lua_instrument" ) != 0 ) {
+                lua_pop( l, 1 );
+                return false;
+            }
+            lua_pushcfunction( l, &instrumented_clock );
+            lua_pushcfunction( l, &instrumented_finish );
+            lua_getglobal( l, "pcall" );
+            /// Bindings exported before luaL_openlibs stay unwrapped.
+            if( !lua_isfunction( l, -1 ) ) {
+                lua_pop( l, 4 );
+                return false;
+            }
+            if( lua_pcall( l, 3, 1, 0 ) != 0 || !lua_isfunction( l, -1 ) ) {
+                lua_pop( l, 1 );
+                return false;
+            }
+            lua_pushlightuserdata( l, &instrument_key );
+            lua_pushvalue( l, -2 );
+            lua_rawset( l, LUA_REGISTRYINDEX );
+        }
+        return true;
+    }
+
+    /// A budgeted pcall in progress. Scopes of one state are chained, inner first.
+    struct BudgetScope
+    {
+        uint64_t                              limit;
+        uint64_t                              executed;
+        bool                                  timed;
+        std::chrono::steady_clock::time_point deadline;
+        const char*                           exceeded;
+        int32_t                               step;
+        int32_t                               mask;
+        /// Instructions until the budget is checked, until the replaced count hook is due and
+        /// the count the hook is armed with, the smaller of both.
+        int32_t                               budget_left;
+        int32_t                               foreign_left;
+        int32_t                               foreign_count;
+        int32_t                               armed;
+        lua_Hook                              previous_hook;
+        int32_t                               previous_mask;
+        int32_t                               previous_count;
+        BudgetScope*                          outer;
+        /// True if the JIT was switched off for the called function.
+        bool                                  interpreted;
+    };
+
+    constexpr int32_t budget_step = 1000;
+
+    void budget_hook(
+        lua_State* l,
+        lua_Debug* ar );
+
+    void arm_budget(
+        lua_State*   l,
+        BudgetScope* scope )
+    {
+        const auto count = scope->foreign_count != 0
+            ? std::min( scope->budget_left, scope->foreign_left )
+            : scope->budget_left;
+        if( count != scope->armed ) {
+            scope->armed = count;
+            lua_sethook( l, &budget_hook, scope->mask, count );
+        }
+    }
+
+    void budget_hook(
+        lua_State* l,
+        lua_Debug* ar )
+    {
+        const auto context   = get_context( l );
+        const auto innermost = context ? context->active_budget : nullptr;
+        if( !innermost ) {
+            return;
+        }
+
+        /// Forward to the hook the budgets replaced, nested budgets replaced each other. Count
+        /// events only reach it once its own count elapsed.
+        auto owner = innermost;
+        while( owner->previous_hook == &budget_hook && owner->outer ) {
+            owner = owner->outer;
+        }
+        const auto foreign = owner->previous_hook && owner->previous_hook != &budget_hook
+            ? owner->previous_hook
+            : nullptr;
+        if( ar->event != LUA_HOOKCOUNT ) {
+            if( foreign ) {
+                foreign( l, ar );
+            }
+            return;
+        }
+        if( innermost->foreign_count != 0 ) {
+            innermost->foreign_left -= innermost->armed;
+            if( innermost->foreign_left <= 0 ) {
+                innermost->foreign_left = innermost->foreign_count;
+                if( foreign ) {
+                    foreign( l, ar );
+                }
+            }
+        }
+        innermost->budget_left -= innermost->armed;
+        if( innermost->budget_left > 0 ) {
+            arm_budget( l, innermost );
+            return;
+        }
+        innermost->budget_left = innermost->step;
+
+        const char* exceeded = nullptr;
+        const auto  now      = std::chrono::steady_clock::now();
+        for( auto scope = innermost; scope; scope = scope->outer ) {
+            scope->executed += static_cast<uint64_t>( innermost->step );
+            if( !scope->exceeded ) {
+                if( scope->limit != 0 && scope->executed >= scope->limit ) {
+                    scope->exceeded = "instruction budget exceeded";
+                }
+                else if( scope->timed && now >= scope->deadline ) {
+                    scope->exceeded = "time budget exceeded";
+                }
+            }
+            exceeded = exceeded ? exceeded : scope->exceeded;
+        }
+        if( exceeded ) {
+            /// Raise on every instruction from now on, a pcall inside the script only delays it.
+            innermost->step        = 1;
+            innermost->budget_left = 1;
+        }
+        arm_budget( l, innermost );
+        if( exceeded ) {
+            luaL_error( l, "%s", exceeded );
+        }
+    }
+
+    int32_t to_jit_flags(
+        const easy_lua::EJitMode mode )
+    {
+        switch( mode ) {
+        case easy_lua::Jit_Off:
+            return LUAJIT_MODE_OFF;
+        case easy_lua::Jit_Flush:
+            return LUAJIT_MODE_FLUSH;
+        default:
+            return LUAJIT_MODE_ON;
+        }
+    }
+
+    /// The 'memory_stats' global, only exported if the state tracks its allocations.
+    int32_t memory_stats_global(
+        easy_lua* lua )
+    {
+        const auto stats = lua->memory_stats();
+        const auto l     = EASY_LUA_CAST_LUA( lua );
+        lua_createtable( l, 0, 6 );
+        lua->push_number( stats.bytes_in_use );
+        lua_setfield( l, -2, "bytes_in_use" );
+        lua->push_number( stats.peak_bytes );
+        lua_setfield( l, -2, "peak_bytes" );
+        lua->push_number( stats.limit );
+        lua_setfield( l, -2, "limit" );
+        lua->push_number( stats.allocations );
+        lua_setfield( l, -2, "allocations" );
+        lua->push_number( stats.failed_allocations );
+        lua_setfield( l, -2, "failed_allocations" );
+        lua_createtable( l, static_cast<int32_t>( stats.buckets.size() ), 0 );
+        for( size_t i = 0; i < stats.buckets.size(); ++i ) {
+            lua->push_number( stats.buckets[ i ] );
+            lua_rawseti( l, -2, static_cast<int32_t>( i + 1 ) );
+        }
+        lua_setfield( l, -2, "buckets" );
+        return lua->pushed();
+    }
+
+    /// The 'binding_stats' global, only exported if the state instruments its bindings.
+    int32_t binding_stats_global(
+        easy_lua* lua )
+    {
+        const auto stats = lua->binding_stats();
+        const auto l     = EASY_LUA_CAST_LUA( lua );
+        lua_createtable( l, 0, static_cast<int32_t>( stats.size() ) );
+        for( const auto& binding : stats ) {
+            lua_createtable( l, 0, 6 );
+            for( const auto& [ name, value ] : {
+                std::make_pair( "calls", binding.calls ),
+                std::make_pair( "errors", binding.errors ),
+                std::make_pair( "total_ns", binding.total_ns ),
+                std::make_pair( "p50_ns", binding.p50_ns ),
+                std::make_pair( "p99_ns", binding.p99_ns ),
+                std::make_pair( "max_ns", binding.max_ns ) } ) {
+                lua->push_number( value );
+                lua_setfield( l, -2, name );
+            }
+            lua_setfield( l, -2, binding.name.c_str() );
+        }
+        return lua->pushed();
+    }
+
+    int destroy_context(
+        lua_State* l )
+    {
+        static_cast<Context*>( lua_touserdata( l, 1 ) )->~Context();
+        return 0;
+    }
+}
 
 easy_lua* easy_lua::initialize(
     const std::string& include_directory )
 {    
-    const auto l = luaL_newstate();
-    if( !l ) {
-        return nullptr;
-    }
+    return initialize( include_directory, Allocator_Default );
+}
 
-    luaL_openlibs( l );
+easy_lua* easy_lua::initialize(
+    const std::string& include_directory,
+    const EAllocator   allocator )
+{
+    Config config;
+    config.allocator = allocator;
     if( !include_directory.empty() ) {
-        script_directory.assign( include_directory );
+        config.include_directories.push_back( include_directory );
     }
+    return initialize( config );
+}
 
-    if( !script_directory.empty() ) {
-        reinterpret_cast<easy_lua*>( l )->export_function( "include", []( easy_lua* lua ) -> int32_t 
-        {
-            if( lua->is_string( 1 ) ) {
-                auto query = script_directory;
-                if( query.back() != '\\' && query.back() != '/' ) {
-                    query.append( "\\" );
-                }
-                query.append( lua->get_string( 1 ) );
+easy_lua* easy_lua::initialize(
+    const Config& config )
+{
+    std::unique_ptr<easy_lua_allocator> instance;
+    switch( config.allocator ) {
+    case Allocator_SizeClass:
+        instance = std::make_unique<easy_lua_size_class_allocator>();
+        break;
+    case Allocator_Arena:
+        instance = std::make_unique<easy_lua_arena_allocator>();
+        break;
+    default:
+        break;
+    }
 
-                if( lua->load_file( query ) != State_Success && lua->pcall( 0, 0, 0 ) != State_Success ) {
-                    printf( "Failed to include file: %s\n", lua->get_string( -1 ) );
-                }
+    auto l = instance
+        ? lua_newstate( easy_lua_allocator::alloc, instance.get() )
+        : nullptr;
+    if( l ) {
+        lua_pushlightuserdata( l, &allocator_key );
+        lua_pushlightuserdata( l, instance.release() );
+        lua_rawset( l, LUA_REGISTRYINDEX );
+    }
+    else {
+        l = luaL_newstate();
+        if( !l ) {
+            return nullptr;
+        }
+        if( config.allocator != Allocator_Default ) {
+            reinterpret_cast<easy_lua*>( l )->attach_tracking_allocator();
+        }
+    }
+    return setup( l, config );
+}
+
+easy_lua* easy_lua::setup(
+    lua_State*    l,
+    const Config& config )
+{
+    new( lua_newuserdata( l, sizeof( Context ) ) ) Context( config );
+    lua_createtable( l, 0, 1 );
+    lua_pushcfunction( l, &destroy_context );
+    lua_setfield( l, -2, "__gc" );
+    lua_setmetatable( l, -2 );
+    lua_pushlightuserdata( l, &context_key );
+    lua_insert( l, -2 );
+    lua_rawset( l, LUA_REGISTRYINDEX );
+
+    const auto lua = reinterpret_cast<easy_lua*>( l );
+    luaL_openlibs( l );
+    if( config.gc_preset != Gc_Default ) {
+        lua->set_gc_preset( config.gc_preset );
+    }
+    lua->export_function( "include", []( easy_lua* lua ) -> int32_t 
+    {
+        if( lua->is_string( 1 ) ) {
+            const auto file = lua->resolve_include( lua->get_string_view( 1 ) );
+            if( lua->load_file( file ) != State_Success || lua->pcall( 0, 0, 0 ) != State_Success ) {
+                printf( "Failed to include file: %s\n", lua->get_string( -1 ) );
             }
-            return 0;
-        } );
+        }
+        return 0;
+    } );
+
+    if( config.instrument_bindings ) {
+        lua->export_function( "binding_stats", &binding_stats_global );
     }
 
-    return reinterpret_cast<easy_lua*>( l );
+    /// Last, setup runs unprotected and must not hit the limit.
+    if( config.memory_limit != 0 || lua->allocator() ) {
+        lua->set_memory_limit( config.memory_limit );
+    }
+    return lua;
 }
 
 easy_lua* easy_lua::shared(
     void* obj )
 {
-    static void* shared_obj = nullptr;
-    if( !shared_obj && obj != nullptr ) {
-        shared_obj = obj;
+    if( obj ) {
+        make_current( static_cast<easy_lua*>( obj ) );
+    }
+    return current();
+}
+
+easy_lua* easy_lua::current()
+{
+    if( current_lua && current_tracked && current_lifetime.expired() ) {
+        current_lua = nullptr;
     }
-    return reinterpret_cast<easy_lua*>( shared_obj );
+    return current_lua;
+}
+
+void easy_lua::make_current(
+    easy_lua* lua )
+{
+    current_lua      = lua;
+    current_lifetime = lua ? lua->lifetime() : std::weak_ptr<void>();
+    current_tracked  = !current_lifetime.expired();
 }
 
 void easy_lua::close(
@@ -55,15 +569,16 @@ void easy_lua::close(
 
 bool easy_lua::execute(
     const std::string_view& script,
-    const bool              from_memory ) const
+    const bool              from_memory,
+    const std::string_view& chunk_name ) const
 {
     if( script.empty() ) {
         return false;
     }
     if( !from_memory ) {
-        return !luaL_dofile( EASY_LUA_CAST_LUA( this ), script.data() );
+        return load_file( script ) == State_Success && pcall( 0, LUA_MULTRET, 0 ) == State_Success;
     }
-    if( luaL_loadstring( EASY_LUA_CAST_LUA( this ), script.data() ) > 0 ) {
+    if( load_buffer( script, chunk_name ) != State_Success ) {
         return false;
     }
     if( lua_pcall( EASY_LUA_CAST_LUA( this ), 0, 0, 0 ) > 0 ) {
@@ -75,6 +590,28 @@ bool easy_lua::execute(
     return true;
 }
 
+easy_lua::EState easy_lua::execute(
+    const std::string_view& script,
+    const Budget&           budget,
+    const bool              from_memory,
+    const std::string_view& chunk_name ) const
+{
+    if( script.empty() ) {
+        return from_memory ? State_Syntax : State_File;
+    }
+
+    const auto l     = EASY_LUA_CAST_LUA( this );
+    const auto top   = lua_gettop( l );
+    auto       state = from_memory
+        ? load_buffer( script, chunk_name )
+        : load_file( script );
+    if( state == State_Success ) {
+        state = pcall( 0, 0, 0, budget );
+    }
+    lua_settop( l, top );
+    return state;
+}
+
 bool easy_lua::is_bool(
     const int32_t stackpos ) const
 {
@@ -160,10 +697,23 @@ const char* easy_lua::get_string(
     return buffer;
 }
 
-easy_lua::EState easy_lua::load_file(
-    const std::string_view& file ) const
+std::string_view easy_lua::get_string_view(
+    const int32_t stackpos ) const
+{
+    size_t     length = 0;
+    const auto buffer = lua_tolstring( EASY_LUA_CAST_LUA( this ), stackpos, &length );
+    if( !buffer ) {
+        return std::string_view();
+    }
+    return std::string_view( buffer, length );
+}
+
+easy_lua::EState easy_lua::load_buffer(
+    const std::string_view& buffer,
+    const std::string_view& chunk_name ) const
 {
-    switch( luaL_loadfile( EASY_LUA_CAST_LUA( this ), file.data() ) ) {
+    const std::string name( chunk_name );
+    switch( luaL_loadbuffer( EASY_LUA_CAST_LUA( this ), buffer.data(), buffer.size(), name.c_str() ) ) {
     case LUA_ERRSYNTAX:
         return State_Syntax;
     case LUA_ERRMEM:
@@ -174,6 +724,29 @@ easy_lua::EState easy_lua::load_file(
     return State_Success;
 }
 
+easy_lua::EState easy_lua::load_file(
+    const std::string_view& file ) const
+{
+    const auto context = get_context( EASY_LUA_CAST_LUA( this ) );
+    if( context && !context->config.use_bytecode_cache ) {
+        switch( luaL_loadfile( EASY_LUA_CAST_LUA( this ), std::string( file ).c_str() ) ) {
+        case LUA_ERRSYNTAX:
+            return State_Syntax;
+        case LUA_ERRMEM:
+            return State_MemAlloc;
+        case LUA_ERRFILE:
+            return State_File;
+        default:
+            break;
+        }
+        return State_Success;
+    }
+    const auto cache = context && context->config.bytecode_cache
+        ? context->config.bytecode_cache
+        : easy_lua_bytecode_cache::shared();
+    return cache->load( this, file );
+}
+
 easy_lua::EState easy_lua::pcall(
     const int32_t num_args,
     const int32_t num_results,
@@ -194,6 +767,104 @@ easy_lua::EState easy_lua::pcall(
     return State_Success;
 }
 
+easy_lua::EState easy_lua::pcall(
+    const int32_t num_args,
+    const int32_t num_results,
+    const int32_t error_function,
+    const Budget& budget ) const
+{
+    if( budget.instructions == 0 && budget.time.count() <= 0 ) {
+        return pcall( num_args, num_results, error_function );
+    }
+
+    const auto l       = EASY_LUA_CAST_LUA( this );
+    const auto context = get_context( l );
+    if( !context ) {
+        lua_settop( l, -num_args - 2 );
+        lua_pushliteral( l, "budgets need a state created by easy_lua" );
+        return State_Runtime;
+    }
+
+    BudgetScope scope;
+    scope.limit          = budget.instructions;
+    scope.executed       = 0;
+    scope.timed          = budget.time.count() > 0;
+    scope.deadline       = std::chrono::steady_clock::now() + budget.time;
+    scope.exceeded       = nullptr;
+    scope.step           = budget.instructions != 0
+        ? static_cast<int32_t>( std::min<uint64_t>( budget.instructions, budget_step ) )
+        : budget_step;
+    scope.previous_hook  = lua_gethook( l );
+    scope.previous_mask  = lua_gethookmask( l );
+    scope.previous_count = lua_gethookcount( l );
+    scope.mask           = LUA_MASKCOUNT | ( scope.previous_hook ? scope.previous_mask & ~LUA_MASKCOUNT : 0 );
+    scope.outer          = context->active_budget;
+    scope.budget_left    = scope.step;
+    scope.foreign_count  = 0;
+    scope.foreign_left   = 0;
+    scope.armed          = 0;
+    scope.interpreted    = false;
+    for( auto budget_scope = scope.outer; budget_scope; budget_scope = budget_scope->outer ) {
+        scope.interpreted = scope.interpreted || budget_scope->interpreted;
+    }
+
+    /// Compiled traces do not run hooks. The traces of the function are flushed and it runs
+    /// interpreted, a copy below it keeps it reachable to switch the JIT on again afterwards.
+    /// Below an interpreting budget it stays off until the outermost one returns.
+    const auto function = lua_gettop( l ) - num_args;
+    const auto handler  = error_function < 0 && error_function > LUA_REGISTRYINDEX
+        ? lua_gettop( l ) + error_function + 1
+        : error_function;
+    const auto jit_off  = !budget.allow_traces;
+    if( jit_off ) {
+        lua_pushvalue( l, function );
+        lua_insert( l, function );
+        luaJIT_setmode( l, function, LUAJIT_MODE_ALLFUNC | LUAJIT_MODE_FLUSH );
+        luaJIT_setmode( l, function, LUAJIT_MODE_ALLFUNC | LUAJIT_MODE_OFF );
+    }
+    const auto restore_jit = jit_off && !scope.interpreted;
+    scope.interpreted      = scope.interpreted || jit_off;
+
+    /// A nested budget takes over the countdown of the count hook the outer one replaced.
+    const auto outer = scope.previous_hook == &budget_hook ? scope.outer : nullptr;
+    if( outer ) {
+        scope.foreign_count = outer->foreign_count;
+        scope.foreign_left  = outer->foreign_left;
+    }
+    else if( scope.previous_hook && ( scope.previous_mask & LUA_MASKCOUNT ) && scope.previous_count > 0 ) {
+        scope.foreign_count = scope.previous_count;
+        scope.foreign_left  = scope.previous_count;
+    }
+
+    context->active_budget = &scope;
+    arm_budget( l, &scope );
+    const auto state = pcall( num_args, num_results, handler );
+    context->active_budget = scope.outer;
+    if( outer ) {
+        outer->foreign_left = scope.foreign_left;
+        outer->armed        = 0;
+        arm_budget( l, outer );
+    }
+    else {
+        lua_sethook( l, scope.previous_hook, scope.previous_mask, scope.previous_count );
+    }
+    if( jit_off ) {
+        if( restore_jit ) {
+            luaJIT_setmode( l, function, LUAJIT_MODE_ALLFUNC | LUAJIT_MODE_ON );
+        }
+        lua_remove( l, function );
+    }
+
+    if( state != State_Success ) {
+        for( auto budget_scope = &scope; budget_scope; budget_scope = budget_scope->outer ) {
+            if( budget_scope->exceeded ) {
+                return State_Budget;
+            }
+        }
+    }
+    return state;
+}
+
 bool easy_lua::top(
     const size_t needed ) const
 {
@@ -221,22 +892,41 @@ const easy_lua* easy_lua::export_class(
         functions.push_back( { nullptr, nullptr } );
     }
 
-    luaL_newmetatable( EASY_LUA_CAST_LUA( this ), metatable_name.data() );
+    luaL_newmetatable( EASY_LUA_CAST_LUA( this ), std::string( metatable_name ).c_str() );
 
     /// For lua 5.2 and above: luaL_setfuncs( l, funcs, nullptr );
     luaL_register( EASY_LUA_CAST_LUA( this ), nullptr, reinterpret_cast<const luaL_Reg*>( functions.data() ) );
+    if( const auto state_config = config(); state_config && state_config->instrument_bindings ) {
+        const auto prefix = std::string( global_name ) + ".";
+        for( const auto& function : functions ) {
+            if( function.name ) {
+                lua_getfield( EASY_LUA_CAST_LUA( this ), -1, function.name );
+                instrument_function( prefix + function.name );
+                lua_setfield( EASY_LUA_CAST_LUA( this ), -2, function.name );
+            }
+        }
+    }
     lua_pushvalue( EASY_LUA_CAST_LUA( this ), -1 );
     lua_setfield( EASY_LUA_CAST_LUA( this ), -1, "__index" );
-    lua_setglobal( EASY_LUA_CAST_LUA( this ), global_name.data() );
 
-    return this;
+    return set_global( global_name );
 }
 
 const easy_lua* easy_lua::export_class(
     const MetaTableArray& metatable_data,
     std::vector<LuaCFunc> functions ) const
 {
-    return export_class( metatable_data[ 0 ], metatable_data[ 1 ], std::move( functions ) );
+    if( !export_class( metatable_data[ 0 ], metatable_data[ 1 ], std::move( functions ) ) ) {
+        return nullptr;
+    }
+
+    /// Replaces what the handle cached before, a re-export may register a new metatable.
+    const auto l = EASY_LUA_CAST_LUA( this );
+    lua_pushlightuserdata( l, metatable_key( metatable_data ) );
+    lua_pushlstring( l, metatable_data[ 1 ].data(), metatable_data[ 1 ].size() );
+    lua_rawget( l, LUA_REGISTRYINDEX );
+    lua_rawset( l, LUA_REGISTRYINDEX );
+    return this;
 }
 
 const easy_lua* easy_lua::export_function(
@@ -246,19 +936,16 @@ const easy_lua* easy_lua::export_function(
     if( name.empty() || !callback ) {
         return nullptr;
     }
-    lua_register( 
-        EASY_LUA_CAST_LUA( this ), 
-        name.data(), 
-        reinterpret_cast<lua_CFunction>( callback )
-    );
+    lua_pushcfunction( EASY_LUA_CAST_LUA( this ), reinterpret_cast<lua_CFunction>( callback ) );
 
-    return this;
+    return instrument_function( name )->set_global( name );
 }
 
 const easy_lua* easy_lua::get_global(
     const std::string_view& name ) const
 {
-    lua_getglobal( EASY_LUA_CAST_LUA( this ), name.data() );
+    lua_pushlstring( EASY_LUA_CAST_LUA( this ), name.data(), name.size() );
+    lua_gettable( EASY_LUA_CAST_LUA( this ), LUA_GLOBALSINDEX );
     return this;
 }
 
@@ -269,7 +956,9 @@ const easy_lua* easy_lua::set_global(
         return nullptr;
     }
 
-    lua_setglobal( EASY_LUA_CAST_LUA( this ), name.data() );
+    lua_pushlstring( EASY_LUA_CAST_LUA( this ), name.data(), name.size() );
+    lua_insert( EASY_LUA_CAST_LUA( this ), -2 );
+    lua_settable( EASY_LUA_CAST_LUA( this ), LUA_GLOBALSINDEX );
 
     return this;
 }
@@ -297,7 +986,7 @@ const easy_lua* easy_lua::push_bool(
 const easy_lua* easy_lua::push_string(
     const std::string_view& str ) const
 {
-    lua_pushstring( EASY_LUA_CAST_LUA( this ), str.data() );
+    lua_pushlstring( EASY_LUA_CAST_LUA( this ), str.data(), str.size() );
     return this;
 }
 
@@ -315,7 +1004,7 @@ int32_t easy_lua::destroy_userdata(
     const int32_t      stackpos,
     const std::string_view& name ) const
 {
-    if( is_userdata( stackpos ) && !name.empty() ) {
+    if( is_userdata( stackpos ) && !name.empty() && !is_userdata_inline( stackpos ) ) {
         const auto data = get_userdata<uintptr_t>( stackpos, name );
         delete data;
     }
@@ -326,7 +1015,71 @@ int32_t easy_lua::destroy_userdata(
     const int32_t         stackpos,
     const MetaTableArray& metatable ) const
 {
-    return destroy_userdata( stackpos, metatable[ 1 ] );
+    if( is_userdata( stackpos ) && !is_userdata_inline( stackpos ) ) {
+        const auto data = get_userdata<uintptr_t>( stackpos, metatable );
+        delete data;
+    }
+    return 0;
+}
+
+bool easy_lua::is_userdata_inline(
+    const int32_t stackpos ) const
+{
+    const auto block = static_cast<char*>( lua_touserdata( EASY_LUA_CAST_LUA( this ), stackpos ) );
+    if( !block || lua_islightuserdata( EASY_LUA_CAST_LUA( this ), stackpos ) ) {
+        return false;
+    }
+    const auto length = lua_objlen( EASY_LUA_CAST_LUA( this ), stackpos );
+    if( length <= sizeof( void* ) ) {
+        return false;
+    }
+    const auto object = *reinterpret_cast<char**>( block );
+    return object >= block + sizeof( void* ) && object < block + length;
+}
+
+bool easy_lua::push_metatable(
+    const MetaTableArray& metatable ) const
+{
+    const auto l = EASY_LUA_CAST_LUA( this );
+    lua_pushlightuserdata( l, metatable_key( metatable ) );
+    lua_rawget( l, LUA_REGISTRYINDEX );
+    if( !lua_isnil( l, -1 ) ) {
+        return true;
+    }
+
+    lua_pop( l, 1 );
+    if( !push_metatable( metatable[ 1 ] ) ) {
+        return false;
+    }
+    lua_pushlightuserdata( l, metatable_key( metatable ) );
+    lua_pushvalue( l, -2 );
+    lua_rawset( l, LUA_REGISTRYINDEX );
+    return true;
+}
+
+bool easy_lua::push_metatable(
+    const std::string_view& name ) const
+{
+    const auto l = EASY_LUA_CAST_LUA( this );
+    lua_pushlstring( l, name.data(), name.size() );
+    lua_rawget( l, LUA_REGISTRYINDEX );
+    return !lua_isnil( l, -1 );
+}
+
+int32_t easy_lua::type_error(
+    const int32_t           stackpos,
+    const std::string_view& expected ) const
+{
+    const auto l = EASY_LUA_CAST_LUA( this );
+    lua_pushlstring( l, expected.data(), expected.size() );
+    const auto message = lua_pushfstring( l, "%s expected, got %s", lua_tostring( l, -1 ), luaL_typename( l, stackpos ) );
+    return luaL_argerror( l, stackpos, message );
+}
+
+void* easy_lua::metatable_key(
+    const MetaTableArray& metatable )
+{
+    return const_cast<MetaTableArray*>( &metatable );
 }
 
 int32_t easy_lua::top() const
@@ -337,15 +1090,410 @@ int32_t easy_lua::top() const
 int32_t easy_lua::pushed(
     const int32_t val ) const
 {
-    if( !EASY_LUA_CAST_LUA( this ) ) {
-        return 0;
-    }
     return val;
 }
 
 void easy_lua::close()
 {
+    if( const auto context = get_context( EASY_LUA_CAST_LUA( this ) ) ) {
+        /// Expire the token before any finalizer runs.
+        context->lifetime.reset();
+    }
+    if( current_lua == this ) {
+        make_current( nullptr );
+    }
+    const auto state_allocator = allocator();
+    if( state_allocator ) {
+        /// LuaJIT only destroys its internal heap on close if its own allocator is installed.
+        void* parent_ud = nullptr;
+        if( const auto parent = state_allocator->parent( &parent_ud ) ) {
+            lua_setallocf( EASY_LUA_CAST_LUA( this ), parent, parent_ud );
+        }
+    }
     lua_close( EASY_LUA_CAST_LUA( this ) );
+    delete state_allocator;
+}
+
+easy_lua_allocator* easy_lua::allocator() const
+{
+    lua_pushlightuserdata( EASY_LUA_CAST_LUA( this ), &allocator_key );
+    lua_rawget( EASY_LUA_CAST_LUA( this ), LUA_REGISTRYINDEX );
+    const auto state_allocator = static_cast<easy_lua_allocator*>(
+        lua_touserdata( EASY_LUA_CAST_LUA( this ), -1 )
+    );
+    lua_pop( EASY_LUA_CAST_LUA( this ), 1 );
+    return state_allocator;
+}
+
+size_t easy_lua::allocated_bytes() const
+{
+    if( const auto state_allocator = allocator() ) {
+        return state_allocator->bytes_in_use();
+    }
+    return static_cast<size_t>( lua_gc( EASY_LUA_CAST_LUA( this ), LUA_GCCOUNT, 0 ) ) * 1024
+         + static_cast<size_t>( lua_gc( EASY_LUA_CAST_LUA( this ), LUA_GCCOUNTB, 0 ) );
+}
+
+easy_lua::MemoryStats easy_lua::memory_stats() const
+{
+    if( const auto state_allocator = allocator() ) {
+        return state_allocator->stats();
+    }
+    MemoryStats stats;
+    stats.bytes_in_use = allocated_bytes();
+    stats.peak_bytes   = stats.bytes_in_use;
+    return stats;
+}
+
+const easy_lua* easy_lua::set_memory_limit(
+    const size_t limit ) const
+{
+    const auto state_allocator = attach_tracking_allocator();
+    if( !state_allocator ) {
+        return nullptr;
+    }
+    const auto context = get_context( EASY_LUA_CAST_LUA( this ) );
+    if( context && !context->memory_stats_exported ) {
+        context->memory_stats_exported = true;
+        export_function( "memory_stats", &memory_stats_global );
+    }
+    state_allocator->set_limit( limit );
+    if( context ) {
+        context->config.memory_limit = limit;
+    }
+    return this;
+}
+
+const easy_lua* easy_lua::set_gc_policy(
+    const GcPolicy& policy ) const
+{
+    const auto l = EASY_LUA_CAST_LUA( this );
+    lua_gc( l, LUA_GCSETPAUSE, policy.pause );
+    lua_gc( l, LUA_GCSETSTEPMUL, policy.stepmul );
+    lua_gc( l, policy.automatic ? LUA_GCRESTART : LUA_GCSTOP, 0 );
+    if( const auto context = get_context( l ) ) {
+        context->gc_policy = policy;
+    }
+    return this;
+}
+
+const easy_lua* easy_lua::set_gc_preset(
+    const EGcPreset preset ) const
+{
+    GcPolicy policy;
+    switch( preset ) {
+    case Gc_Throughput:
+        policy.pause = 400;
+        break;
+    case Gc_LowLatency:
+        policy.pause   = 150;
+        policy.stepmul = 150;
+        break;
+    case Gc_Manual:
+        policy.automatic = false;
+        break;
+    default:
+        break;
+    }
+    if( const auto context = get_context( EASY_LUA_CAST_LUA( this ) ) ) {
+        context->config.gc_preset = preset;
+    }
+    return set_gc_policy( policy );
+}
+
+easy_lua::GcPolicy easy_lua::gc_policy() const
+{
+    const auto context = get_context( EASY_LUA_CAST_LUA( this ) );
+    return context ? context->gc_policy : GcPolicy();
+}
+
+easy_lua::GcStep easy_lua::gc_step_for(
+    const std::chrono::microseconds budget,
+    const int32_t                   step_kb ) const
+{
+    using clock = std::chrono::steady_clock;
+    const auto l       = EASY_LUA_CAST_LUA( this );
+    const auto context = get_context( l );
+    GcStep     result;
+    result.bytes_before = allocated_bytes();
+
+    const auto start = clock::now();
+    auto       now   = start;
+    while( now - start < budget && !result.cycle_finished ) {
+        const auto step_start = now;
+        result.cycle_finished = lua_gc( l, LUA_GCSTEP, step_kb ) != 0;
+        now                   = clock::now();
+
+        const auto step     = std::chrono::duration_cast<std::chrono::nanoseconds>( now - step_start );
+        result.longest_step = std::max( result.longest_step, step );
+        ++result.steps;
+    }
+    result.elapsed     = std::chrono::duration_cast<std::chrono::nanoseconds>( now - start );
+    result.bytes_after = allocated_bytes();
+
+    if( context ) {
+        /// A step rearms the automatic collector, keep manual states manual.
+        if( !context->gc_policy.automatic ) {
+            lua_gc( l, LUA_GCSTOP, 0 );
+        }
+        auto& stats        = context->gc_stats;
+        stats.steps       += result.steps;
+        stats.cycles      += result.cycle_finished ? 1 : 0;
+        stats.total       += result.elapsed;
+        stats.longest_step = std::max( stats.longest_step, result.longest_step );
+    }
+    return result;
+}
+
+easy_lua::GcStats easy_lua::gc_stats() const
+{
+    const auto context = get_context( EASY_LUA_CAST_LUA( this ) );
+    return context ? context->gc_stats : GcStats();
+}
+
+const easy_lua* easy_lua::set_jit_mode(
+    const EJitMode mode ) const
+{
+    return luaJIT_setmode( EASY_LUA_CAST_LUA( this ), 0, LUAJIT_MODE_ENGINE | to_jit_flags( mode ) ) != 0
+        ? this
+        : nullptr;
+}
+
+const easy_lua* easy_lua::set_jit_mode(
+    const int32_t  stackpos,
+    const EJitMode mode,
+    const bool     recursive ) const
+{
+    const auto l = EASY_LUA_CAST_LUA( this );
+    if( !lua_isfunction( l, stackpos ) || lua_iscfunction( l, stackpos ) ) {
+        return nullptr;
+    }
+    /// luaJIT_setmode takes the function from an absolute index, index 0 means the caller.
+    const auto index = stackpos > 0 ? stackpos : lua_gettop( l ) + stackpos + 1;
+    const auto scope = recursive ? LUAJIT_MODE_ALLFUNC : LUAJIT_MODE_FUNC;
+    return luaJIT_setmode( l, index, scope | to_jit_flags( mode ) ) != 0
+        ? this
+        : nullptr;
+}
+
+const easy_lua* easy_lua::set_jit_options(
+    const JitOptions& options ) const
+{
+    const auto l = EASY_LUA_CAST_LUA( this );
+    if( !push_jit_helper( l, "options" ) ) {
+        return nullptr;
+    }
+
+    auto num_args = 0;
+    if( options.level >= 0 ) {
+        lua_pushinteger( l, options.level );
+        ++num_args;
+    }
+    for( const auto& [ name, value ] : {
+        std::make_pair( "hotloop", options.hotloop ),
+        std::make_pair( "hotexit", options.hotexit ),
+        std::make_pair( "maxtrace", options.maxtrace ),
+        std::make_pair( "maxrecord", options.maxrecord ),
+        std::make_pair( "maxmcode", options.maxmcode ),
+        std::make_pair( "sizemcode", options.sizemcode ) } ) {
+        if( value >= 0 ) {
+            lua_pushfstring( l, "%s=%d", name, value );
+            ++num_args;
+        }
+    }
+    if( lua_pcall( l, num_args, 0, 0 ) != 0 ) {
+        lua_pop( l, 1 );
+        return nullptr;
+    }
+    return this;
+}
+
+const easy_lua* easy_lua::collect_jit_stats(
+    const bool enable ) const
+{
+    const auto l = EASY_LUA_CAST_LUA( this );
+    if( !push_jit_helper( l, "attach" ) ) {
+        return nullptr;
+    }
+    lua_pushboolean( l, enable ? 1 : 0 );
+    if( lua_pcall( l, 1, 0, 0 ) != 0 ) {
+        lua_pop( l, 1 );
+        return nullptr;
+    }
+    return this;
+}
+
+easy_lua::JitStats easy_lua::jit_stats() const
+{
+    const auto l = EASY_LUA_CAST_LUA( this );
+    JitStats   stats;
+    if( !push_jit_helper( l, "stats" ) ) {
+        return stats;
+    }
+
+    const auto read = [ l ]( const char* name )
+    {
+        lua_getfield( l, -1, name );
+        const auto value = static_cast<uint64_t>( lua_tonumber( l, -1 ) );
+        lua_pop( l, 1 );
+        return value;
+    };
+    stats.started  = read( "started" );
+    stats.compiled = read( "compiled" );
+    stats.aborted  = read( "aborted" );
+    stats.flushed  = read( "flushed" );
+
+    lua_getfield( l, -1, "aborts" );
+    lua_pushnil( l );
+    while( lua_next( l, -2 ) != 0 ) {
+        const std::string reason = lua_tostring( l, -2 );
+        lua_pushnil( l );
+        while( lua_next( l, -2 ) != 0 ) {
+            stats.aborts.push_back( JitAbort{ reason, lua_tostring( l, -2 ), static_cast<uint64_t>( lua_tonumber( l, -1 ) ) } );
+            lua_pop( l, 1 );
+        }
+        lua_pop( l, 1 );
+    }
+    lua_pop( l, 2 );
+
+    std::sort( stats.aborts.begin(), stats.aborts.end(), []( const JitAbort& a, const JitAbort& b )
+    {
+        return a.count > b.count;
+    } );
+    return stats;
+}
+
+void easy_lua::reset_jit_stats() const
+{
+    const auto l = EASY_LUA_CAST_LUA( this );
+    if( push_jit_helper( l, "reset" ) && lua_pcall( l, 0, 0, 0 ) != 0 ) {
+        lua_pop( l, 1 );
+    }
+}
+
+const easy_lua* easy_lua::instrument_function(
+    const std::string_view& name ) const
+{
+    const auto l       = EASY_LUA_CAST_LUA( this );
+    const auto context = get_context( l );
+    if( !context || !context->config.instrument_bindings || !lua_isfunction( l, -1 ) ) {
+        return this;
+    }
+    if( !push_instrument_wrapper( l ) ) {
+        return this;
+    }
+    /// Registering a name twice keeps counting into the same entry.
+    const auto [ binding, inserted ] = context->bindings.try_emplace( std::string( name ) );
+    lua_pushvalue( l, -2 );
+    lua_pushlightuserdata( l, &binding->second );
+    if( lua_pcall( l, 2, 1, 0 ) != 0 ) {
+        lua_pop( l, 1 );
+        if( inserted ) {
+            context->bindings.erase( binding );
+        }
+        return this;
+    }
+    lua_replace( l, -2 );
+    return this;
+}
+
+std::vector<easy_lua::BindingStats> easy_lua::binding_stats() const
+{
+    std::vector<BindingStats> stats;
+    const auto                context = get_context( EASY_LUA_CAST_LUA( this ) );
+    if( !context ) {
+        return stats;
+    }
+
+    stats.reserve( context->bindings.size() );
+    for( const auto& [ name, binding ] : context->bindings ) {
+        BindingStats entry;
+        entry.name     = name;
+        entry.calls    = binding.calls;
+        entry.errors   = binding.errors;
+        entry.total_ns = binding.total_ns;
+        entry.max_ns   = binding.max_ns;
+        if( binding.calls != 0 ) {
+            entry.p50_ns = binding.percentile( 0.50 );
+            entry.p99_ns = binding.percentile( 0.99 );
+        }
+        stats.push_back( std::move( entry ) );
+    }
+    std::sort( stats.begin(), stats.end(), []( const BindingStats& a, const BindingStats& b )
+    {
+        return a.total_ns > b.total_ns;
+    } );
+    return stats;
+}
+
+void easy_lua::reset_binding_stats() const
+{
+    if( const auto context = get_context( EASY_LUA_CAST_LUA( this ) ) ) {
+        for( auto& [ name, binding ] : context->bindings ) {
+            binding = Binding();
+        }
+    }
+}
+
+easy_lua::Config* easy_lua::config() const
+{
+    const auto context = get_context( EASY_LUA_CAST_LUA( this ) );
+    return context ? &context->config : nullptr;
+}
+
+std::weak_ptr<void> easy_lua::lifetime() const
+{
+    const auto context = get_context( EASY_LUA_CAST_LUA( this ) );
+    return context ? std::weak_ptr<void>( context->lifetime ) : std::weak_ptr<void>();
+}
+
+const easy_lua* easy_lua::add_include_directory(
+    const std::string_view& directory ) const
+{
+    const auto state_config = config();
+    if( !state_config || directory.empty() ) {
+        return nullptr;
+    }
+    state_config->include_directories.emplace_back( directory );
+    return this;
+}
+
+std::string easy_lua::resolve_include(
+    const std::string_view& file ) const
+{
+    const auto state_config = config();
+    if( state_config ) {
+        std::error_code ec;
+        for( const auto& directory : state_config->include_directories ) {
+            auto path = std::filesystem::path( directory ) / file;
+            if( std::filesystem::is_regular_file( path, ec ) ) {
+                return path.string();
+            }
+        }
+    }
+    return std::string( file );
+}
+
+easy_lua_allocator* easy_lua::attach_tracking_allocator() const
+{
+    if( const auto state_allocator = allocator() ) {
+        return state_allocator;
+    }
+
+    void*      parent_ud = nullptr;
+    const auto parent    = lua_getallocf( EASY_LUA_CAST_LUA( this ), &parent_ud );
+    const auto tracking  = new easy_lua_tracking_allocator( parent, parent_ud );
+
+    lua_pushlightuserdata( EASY_LUA_CAST_LUA( this ), &allocator_key );
+    lua_pushlightuserdata( EASY_LUA_CAST_LUA( this ), tracking );
+    lua_rawset( EASY_LUA_CAST_LUA( this ), LUA_REGISTRYINDEX );
+
+    /// Seed after the registry insert so its allocation is part of the baseline.
+    tracking->seed(
+        static_cast<size_t>( lua_gc( EASY_LUA_CAST_LUA( this ), LUA_GCCOUNT, 0 ) ) * 1024
+      + static_cast<size_t>( lua_gc( EASY_LUA_CAST_LUA( this ), LUA_GCCOUNTB, 0 ) )
+    );
+    lua_setallocf( EASY_LUA_CAST_LUA( this ), easy_lua_allocator::alloc, tracking );
+    return tracking;
 }
 
-std::string easy_lua::script_directory;
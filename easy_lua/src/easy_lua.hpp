@@ -3,7 +3,7 @@
 /// Created:            18.02.2017
 /// 
 /// Last modified by:   ReactiioN
-/// Last modified on:   21.01.2018
+/// Last modified on:   16.10.2026
 ///-------------------------------------------------------------------------------------------------
 ///     Copyright (c) ReactiioN <https://reactiion.pw>. All rights reserved.
 ///-------------------------------------------------------------------------------------------------
@@ -45,12 +45,16 @@
 #else
 #include <lua.hpp>
 #endif
+#include "easy_lua_stack.hpp"
 #include <array>
+#include <chrono>
+#include <memory>
+#include <new>
 #include <string>
 #include <string_view>
 #include <vector>
 
-#if !defined(_HAS_CXX17)
+#if !defined(_HAS_CXX17) && __cplusplus < 201703L
 #error "easy_lua requires a compiler which supports C++17"
 #endif
 
@@ -69,26 +73,48 @@
     }
 #endif
 
+#if !defined(EASY_LUA_EXPORT)
+#if defined(_WIN32)
+#define EASY_LUA_EXPORT __declspec(dllexport)
+#else
+#define EASY_LUA_EXPORT __attribute__((visibility("default")))
+#endif
+#endif
+
 #if !defined(EASY_LUA_MAKE_PLUGIN)
 #define EASY_LUA_MAKE_PLUGIN(onPluginLoad, onPluginUnload, onPluginGetDescription) extern "C" {   \
-    bool __declspec(dllexport) plugin_load( easy_lua* lua )                                       \
+    EASY_LUA_EXPORT bool plugin_load( easy_lua* lua )                                             \
     {                                                                                             \
         return onPluginLoad( lua );                                                               \
     }                                                                                             \
-    void __declspec(dllexport) plugin_unload()                                                    \
+    EASY_LUA_EXPORT void plugin_unload()                                                          \
     {                                                                                             \
         onPluginUnload();                                                                         \
     }                                                                                             \
-    void __declspec(dllexport) plugin_get_description( easy_lua::PluginDescription* description ) \
+    EASY_LUA_EXPORT void plugin_get_description( easy_lua::PluginDescription* description )       \
     {                                                                                             \
         onPluginGetDescription( description );                                                    \
     }                                                                                             \
 }
 #endif
 
+class easy_lua_allocator;
+class easy_lua_bytecode_cache;
+
+template<typename R>
+struct easy_lua_result;
+
 class easy_lua
 {
 public:
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// The global and metatable name of an exported class. The address of a handle doubles as
+    /// light userdata registry key of its metatable, see push_metatable, so handles have to
+    /// outlive the states using them; EASY_LUA_CREATE_METATABLE_DATA creates static ones.
+    /// Temporary names go through the overloads taking the metatable name.
+    /// </summary>
+    ///-------------------------------------------------------------------------------------------------
     using MetaTableArray = std::array<std::string_view, 2>;
     using CheckStackFn = bool( *)( const easy_lua*, int32_t );
 
@@ -114,6 +140,54 @@ public:
         /// An enum constant representing the state Error handling option. 
         /// </summary>
         State_ErrHandling,
+        /// <summary> 
+        /// An enum constant representing the state file option. 
+        /// </summary>
+        State_File,
+        /// <summary> 
+        /// An enum constant representing the state budget exceeded option. 
+        /// </summary>
+        State_Budget,
+    };
+
+    enum EAllocator : uint8_t
+    {
+        /// <summary> 
+        /// The allocator of luaL_newstate. 
+        /// </summary>
+        Allocator_Default = 0,
+        /// <summary> 
+        /// Size class free lists for small blocks, malloc for large ones. 
+        /// </summary>
+        Allocator_SizeClass,
+        /// <summary> 
+        /// A bump arena released in one shot when the state is closed. 
+        /// </summary>
+        Allocator_Arena,
+        /// <summary> 
+        /// The allocator of luaL_newstate wrapped with allocation statistics. 
+        /// </summary>
+        Allocator_Tracking,
+    };
+
+    enum EGcPreset : uint8_t
+    {
+        /// <summary> 
+        /// The lua defaults, pause 200 and stepmul 200.
+        /// </summary>
+        Gc_Default = 0,
+        /// <summary> 
+        /// Fewer cycles at the cost of memory, pause 400 and stepmul 200.
+        /// </summary>
+        Gc_Throughput,
+        /// <summary> 
+        /// Earlier cycles in smaller steps, pause 150 and stepmul 150.
+        /// </summary>
+        Gc_LowLatency,
+        /// <summary> 
+        /// No automatic collection, only gc_step_for and full collections collect.
+        /// </summary>
+        Gc_Manual,
     };
 
     struct PluginDescription
@@ -132,6 +206,274 @@ public:
         std::string description;
     };
 
+    struct MemoryStats
+    {
+        /// <summary> 
+        /// The number of size buckets, bucket i counts requests up to 16 * 2^i bytes.
+        /// </summary>
+        static constexpr size_t bucket_count = 11;
+        /// <summary> 
+        /// The bytes currently allocated.
+        /// </summary>
+        size_t bytes_in_use = 0;
+        /// <summary> 
+        /// The highest value bytes_in_use reached.
+        /// </summary>
+        size_t peak_bytes = 0;
+        /// <summary> 
+        /// The hard cap of bytes_in_use, zero if unlimited.
+        /// </summary>
+        size_t limit = 0;
+        /// <summary> 
+        /// The number of allocation and growth requests.
+        /// </summary>
+        uint64_t allocations = 0;
+        /// <summary> 
+        /// The number of requests refused because of the limit or an exhausted allocator.
+        /// </summary>
+        uint64_t failed_allocations = 0;
+        /// <summary> 
+        /// The number of requests per size bucket, the last bucket holds everything larger.
+        /// </summary>
+        std::array<uint64_t, bucket_count> buckets = {};
+    };
+
+    struct Config
+    {
+        /// <summary> 
+        /// The directories searched by the include function, in order.
+        /// </summary>
+        std::vector<std::string> include_directories;
+        /// <summary> 
+        /// The allocator policy.
+        /// </summary>
+        EAllocator allocator = Allocator_Default;
+        /// <summary> 
+        /// The hard cap of the state memory in bytes, zero if unlimited.
+        /// </summary>
+        size_t memory_limit = 0;
+        /// <summary> 
+        /// False to compile every loaded file from source.
+        /// </summary>
+        bool use_bytecode_cache = true;
+        /// <summary> 
+        /// The bytecode cache of the state, null for the process wide cache.
+        /// </summary>
+        easy_lua_bytecode_cache* bytecode_cache = nullptr;
+        /// <summary> 
+        /// True to measure every function registered afterwards and export binding_stats() to
+        /// scripts, see binding_stats.
+        /// </summary>
+        bool instrument_bindings = false;
+        /// <summary> 
+        /// The collector policy applied when the state is set up.
+        /// </summary>
+        EGcPreset gc_preset = Gc_Default;
+    };
+
+    enum EJitMode : uint8_t
+    {
+        /// <summary> 
+        /// Interpret only, compiled traces are flushed.
+        /// </summary>
+        Jit_Off = 0,
+        /// <summary> 
+        /// Compile hot loops and functions.
+        /// </summary>
+        Jit_On,
+        /// <summary> 
+        /// Flush the compiled traces, compiling goes on.
+        /// </summary>
+        Jit_Flush,
+    };
+
+    struct JitOptions
+    {
+        /// <summary> 
+        /// The optimization level 0 - 3, negative values keep the current setting in every field.
+        /// </summary>
+        int32_t level = -1;
+        /// <summary> 
+        /// The number of iterations before a loop is compiled.
+        /// </summary>
+        int32_t hotloop = -1;
+        /// <summary> 
+        /// The number of taken exits before a side trace is compiled.
+        /// </summary>
+        int32_t hotexit = -1;
+        /// <summary> 
+        /// The maximum number of traces in the cache.
+        /// </summary>
+        int32_t maxtrace = -1;
+        /// <summary> 
+        /// The maximum number of recorded IR instructions per trace.
+        /// </summary>
+        int32_t maxrecord = -1;
+        /// <summary> 
+        /// The maximum total size of all machine code areas in KBytes.
+        /// </summary>
+        int32_t maxmcode = -1;
+        /// <summary> 
+        /// The size of each machine code area in KBytes.
+        /// </summary>
+        int32_t sizemcode = -1;
+    };
+
+    struct GcPolicy
+    {
+        /// <summary> 
+        /// The memory growth in percent after a cycle before the next one starts.
+        /// </summary>
+        int32_t pause = 200;
+        /// <summary> 
+        /// The collector speed relative to allocation in percent.
+        /// </summary>
+        int32_t stepmul = 200;
+        /// <summary> 
+        /// False to collect only in gc_step_for and full collections.
+        /// </summary>
+        bool automatic = true;
+    };
+
+    struct GcStep
+    {
+        /// <summary> 
+        /// The number of collector steps performed.
+        /// </summary>
+        uint64_t steps = 0;
+        /// <summary> 
+        /// The time spent collecting.
+        /// </summary>
+        std::chrono::nanoseconds elapsed = std::chrono::nanoseconds::zero();
+        /// <summary> 
+        /// The longest single step.
+        /// </summary>
+        std::chrono::nanoseconds longest_step = std::chrono::nanoseconds::zero();
+        /// <summary> 
+        /// The bytes in use before the first step.
+        /// </summary>
+        size_t bytes_before = 0;
+        /// <summary> 
+        /// The bytes in use after the last step.
+        /// </summary>
+        size_t bytes_after = 0;
+        /// <summary> 
+        /// True if a collection cycle finished.
+        /// </summary>
+        bool cycle_finished = false;
+    };
+
+    struct GcStats
+    {
+        /// <summary> 
+        /// The number of steps performed by gc_step_for.
+        /// </summary>
+        uint64_t steps = 0;
+        /// <summary> 
+        /// The number of cycles gc_step_for finished.
+        /// </summary>
+        uint64_t cycles = 0;
+        /// <summary> 
+        /// The time spent in gc_step_for steps.
+        /// </summary>
+        std::chrono::nanoseconds total = std::chrono::nanoseconds::zero();
+        /// <summary> 
+        /// The longest single step.
+        /// </summary>
+        std::chrono::nanoseconds longest_step = std::chrono::nanoseconds::zero();
+    };
+
+    struct Budget
+    {
+        /// <summary> 
+        /// The maximum number of VM instructions, checked every 1000 instructions. Zero if unlimited.
+        /// </summary>
+        uint64_t instructions = 0;
+        /// <summary> 
+        /// The maximum wall-clock time, checked with the instructions. Zero if unlimited.
+        /// </summary>
+        std::chrono::microseconds time = std::chrono::microseconds::zero();
+        /// <summary> 
+        /// Keeps the JIT on for the called function. Compiled traces do not run hooks, so by
+        /// default the traces of the function and the functions defined inside are flushed and
+        /// they run interpreted until the call returned, then the JIT is switched on for them
+        /// again. True is faster, but a compiled loop is not interrupted.
+        /// </summary>
+        bool allow_traces = false;
+    };
+
+    struct BindingStats
+    {
+        /// <summary> 
+        /// The binding name, "Global.method" for class methods.
+        /// </summary>
+        std::string name;
+        /// <summary> 
+        /// The number of calls.
+        /// </summary>
+        uint64_t calls = 0;
+        /// <summary> 
+        /// The number of calls which raised an error.
+        /// </summary>
+        uint64_t errors = 0;
+        /// <summary> 
+        /// The cumulative latency in nanoseconds.
+        /// </summary>
+        uint64_t total_ns = 0;
+        /// <summary> 
+        /// The median latency in nanoseconds, accurate to 25%.
+        /// </summary>
+        uint64_t p50_ns = 0;
+        /// <summary> 
+        /// The 99th percentile latency in nanoseconds, accurate to 25%.
+        /// </summary>
+        uint64_t p99_ns = 0;
+        /// <summary> 
+        /// The highest latency in nanoseconds.
+        /// </summary>
+        uint64_t max_ns = 0;
+    };
+
+    struct JitAbort
+    {
+        /// <summary> 
+        /// The abort reason, e.g. "NYI: bytecode 51".
+        /// </summary>
+        std::string reason;
+        /// <summary> 
+        /// The chunk and line the trace was aborted at.
+        /// </summary>
+        std::string location;
+        /// <summary> 
+        /// The number of aborts with this reason at this location.
+        /// </summary>
+        uint64_t count = 0;
+    };
+
+    struct JitStats
+    {
+        /// <summary> 
+        /// The number of traces the recorder started.
+        /// </summary>
+        uint64_t started = 0;
+        /// <summary> 
+        /// The number of traces compiled to machine code.
+        /// </summary>
+        uint64_t compiled = 0;
+        /// <summary> 
+        /// The number of traces aborted, see aborts.
+        /// </summary>
+        uint64_t aborted = 0;
+        /// <summary> 
+        /// The number of trace cache flushes.
+        /// </summary>
+        uint64_t flushed = 0;
+        /// <summary> 
+        /// The aborts grouped by reason and location, most frequent first.
+        /// </summary>
+        std::vector<JitAbort> aborts;
+    };
+
     /// <summary> 
     /// The load plugin callback typedef.
     /// </summary>
@@ -177,17 +519,70 @@ public:
         const std::string& include_directory );
 
     ///-------------------------------------------------------------------------------------------------
-    /// <summary>   Shared the given object. </summary>
+    /// <summary>   
+    /// Initializes this object with an allocator policy. LuaJIT builds which reject custom
+    /// allocators (x64 without GC64) fall back to the default allocator.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="include_directory">    Pathname of the include directory. </param>
+    /// <param name="allocator">            The allocator policy. </param>
+    ///
+    /// <returns>   Null if it fails, else a pointer to an easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    static easy_lua* initialize(
+        const std::string& include_directory,
+        EAllocator         allocator );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   
+    /// Initializes a state with its own configuration. The configuration is kept in the state,
+    /// so independent states never share mutable data.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="config">   The configuration. </param>
+    ///
+    /// <returns>   Null if it fails, else a pointer to an easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    static easy_lua* initialize(
+        const Config& config );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   
+    /// Makes 'obj' the current state of the calling thread if it is non-null, see make_current.
+    /// </summary>
     ///
     /// <remarks>   ReactiioN, 18.01.2018. </remarks>
     ///
     /// <param name="obj">  [in,out] (Optional) If non-null, the object. </param>
     ///
-    /// <returns>   Null if it fails, else a pointer to an easy_lua. </returns>
+    /// <returns>   Null if there is no current state, else a pointer to an easy_lua. </returns>
     ///-------------------------------------------------------------------------------------------------
     static easy_lua* shared(
         void* obj = nullptr );
 
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the current state of the calling thread. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   Null if none was set or it was closed since, else a pointer to an easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    static easy_lua* current();
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Sets or resets the current state of the calling thread. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">  The lua, null to reset. </param>
+    ///-------------------------------------------------------------------------------------------------
+    static void make_current(
+        easy_lua* lua );
+
     ///-------------------------------------------------------------------------------------------------
     /// <summary>   Closes the given lua. </summary>
     ///
@@ -201,16 +596,36 @@ public:
     ///-------------------------------------------------------------------------------------------------
     /// <summary>   Executes. </summary>
     ///
-    /// <remarks>   ReactiioN, 18.01.2018. </remarks>
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
     ///
     /// <param name="script">       The script. </param>
     /// <param name="from_memory">  (Optional) True to from memory. </param>
+    /// <param name="chunk_name">   (Optional) The chunk name used in messages of in-memory scripts. </param>
     ///
     /// <returns>   True if it succeeds, false if it fails. </returns>
     ///-------------------------------------------------------------------------------------------------
     bool execute(
         const std::string_view& script,
-        bool                    from_memory = false ) const;
+        bool                    from_memory = false,
+        const std::string_view& chunk_name = "=easy_lua" ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Executes with an execution budget, see pcall. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="script">       The script. </param>
+    /// <param name="budget">       The budget. </param>
+    /// <param name="from_memory">  (Optional) True to from memory. </param>
+    /// <param name="chunk_name">   (Optional) The chunk name used in messages of in-memory scripts. </param>
+    ///
+    /// <returns>   An EState, the error message is popped. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    EState execute(
+        const std::string_view& script,
+        const Budget&           budget,
+        bool                    from_memory = false,
+        const std::string_view& chunk_name = "=easy_lua" ) const;
 
     ///-------------------------------------------------------------------------------------------------
     /// <summary>   Query if 'stackpos' is bool. </summary>
@@ -319,9 +734,41 @@ public:
         bool    pop_value = false ) const;
 
     ///-------------------------------------------------------------------------------------------------
-    /// <summary>   Loads a file. </summary>
+    /// <summary>   
+    /// Gets a string including its length and embedded zeros. The view is only valid while the
+    /// value stays on the stack.
+    /// </summary>
     ///
-    /// <remarks>   ReactiioN, 18.01.2018. </remarks>
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="stackpos"> The stackpos. </param>
+    ///
+    /// <returns>   An empty view if it fails, else the string. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    std::string_view get_string_view(
+        int32_t stackpos ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Loads a buffer holding source or bytecode. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="buffer">       The buffer, it does not need to be zero terminated. </param>
+    /// <param name="chunk_name">   The chunk name. </param>
+    ///
+    /// <returns>   An EState. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    EState load_buffer(
+        const std::string_view& buffer,
+        const std::string_view& chunk_name ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   
+    /// Loads a file. Compiled chunks are served from the bytecode cache while the file is
+    /// unchanged.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
     ///
     /// <param name="file"> The file. </param>
     ///
@@ -346,6 +793,30 @@ public:
         int32_t num_results,
         int32_t error_function ) const;
 
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   
+    /// Pcalls with an execution budget enforced by a count hook. Exceeding it raises an error
+    /// which keeps being raised until the call returned, scripts can not catch it for good.
+    /// A hook installed before keeps receiving its events, count events at its own interval,
+    /// and is restored afterwards, budgets nest. Functions defined outside the called one keep
+    /// their compiled traces, and the JIT mode set for the called one is reset to on.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="num_args">         Number of arguments. </param>
+    /// <param name="num_results">      Number of results. </param>
+    /// <param name="error_function">   The error function. </param>
+    /// <param name="budget">           The budget. </param>
+    ///
+    /// <returns>   State_Budget if the budget was exceeded, else see pcall. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    EState pcall(
+        int32_t       num_args,
+        int32_t       num_results,
+        int32_t       error_function,
+        const Budget& budget ) const;
+
     ///-------------------------------------------------------------------------------------------------
     /// <summary>   Tops the given needed. </summary>
     ///
@@ -516,16 +987,31 @@ public:
         const MetaTableArray& metatable ) const;
 
     ///-------------------------------------------------------------------------------------------------
-    /// <summary>   Pushed the given value. </summary>
+    /// <summary>   
+    /// Query if the userdata at 'stackpos' stores its object inline (see new_userdata_value)
+    /// instead of pointing to an object owned elsewhere.
+    /// </summary>
     ///
-    /// <remarks>   ReactiioN, 21.01.2018. </remarks>
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
     ///
-    /// <param name="val">  (Optional) The value. </param>
+    /// <param name="stackpos"> The stackpos. </param>
     ///
-    /// <returns>   An int32_t. </returns>
+    /// <returns>   True if inline, false if not. </returns>
     ///-------------------------------------------------------------------------------------------------
-    int32_t pushed(
-        int32_t val = 1 ) const;
+    bool is_userdata_inline(
+        int32_t stackpos ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Pushed the given value. </summary>
+    ///
+    /// <remarks>   ReactiioN, 21.01.2018. </remarks>
+    ///
+    /// <param name="val">  (Optional) The value. </param>
+    ///
+    /// <returns>   An int32_t. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    int32_t pushed(
+        int32_t val = 1 ) const;
 
     ///-------------------------------------------------------------------------------------------------
     /// <summary>   Gets the top. </summary>
@@ -536,6 +1022,56 @@ public:
     ///-------------------------------------------------------------------------------------------------
     int32_t top() const;
 
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Pushes the metatable cached for the handle, nil if it was never exported. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="metatable">    The metatable handle. </param>
+    ///
+    /// <returns>   True if a metatable was pushed, false if nil was pushed. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    bool push_metatable(
+        const MetaTableArray& metatable ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the registry key the metatable of a handle is cached under. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="metatable">    The metatable handle. </param>
+    ///
+    /// <returns>   The key, pushed as light userdata. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    static void* metatable_key(
+        const MetaTableArray& metatable );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Pushes the metatable registered under 'name', nil if there is none. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="name"> The metatable name, does not have to be NUL terminated. </param>
+    ///
+    /// <returns>   True if a metatable was pushed, false if nil was pushed. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    bool push_metatable(
+        const std::string_view& name ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Raises the "'expected' expected, got type" argument error of luaL_typerror. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="stackpos"> The argument. </param>
+    /// <param name="expected"> The expected type, does not have to be NUL terminated. </param>
+    ///
+    /// <returns>   Does not return. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    int32_t type_error(
+        int32_t                 stackpos,
+        const std::string_view& expected ) const;
+
     ///-------------------------------------------------------------------------------------------------
     /// <summary>   Closes this object. </summary>
     ///
@@ -543,6 +1079,280 @@ public:
     ///-------------------------------------------------------------------------------------------------
     void close();
 
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the configuration of the state. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   Null if the state was not created by initialize, else the configuration. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    Config* config() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   
+    /// Gets a token which expires once the state is closed. Objects outliving the state check it
+    /// before touching the state.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   An empty pointer if the state was not created by initialize, else the token. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    std::weak_ptr<void> lifetime() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Appends a directory searched by the include function. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="directory">    Pathname of the directory. </param>
+    ///
+    /// <returns>   Null if it fails, else a pointer to a const easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    const easy_lua* add_include_directory(
+        const std::string_view& directory ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   
+    /// Resolves 'file' against the include directories of the state. The first existing match
+    /// wins, 'file' itself is returned if there is none.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="file"> The file. </param>
+    ///
+    /// <returns>   The resolved pathname. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    std::string resolve_include(
+        const std::string_view& file ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the allocator the state was created with. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   Null if the default allocator is used, else the allocator. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    easy_lua_allocator* allocator() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the number of bytes allocated by the state. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   A size_t. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    size_t allocated_bytes() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   
+    /// Gets the allocation statistics of the state. States tracking their allocations, through
+    /// Config::allocator or a memory limit, also export them to scripts as memory_stats().
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   
+    /// The statistics, only bytes_in_use is filled if the state uses the default allocator.
+    /// </returns>
+    ///-------------------------------------------------------------------------------------------------
+    MemoryStats memory_stats() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   
+    /// Sets a hard cap on the bytes allocated by the state. Allocations exceeding it fail and
+    /// surface as State_MemAlloc. States on the default allocator get a tracking allocator
+    /// attached.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="limit">    The limit in bytes, zero to remove it. </param>
+    ///
+    /// <returns>   Null if it fails, else a pointer to a const easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    const easy_lua* set_memory_limit(
+        size_t limit ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Sets the collector policy of the state. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="policy">   The policy. </param>
+    ///
+    /// <returns>   A pointer to a const easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    const easy_lua* set_gc_policy(
+        const GcPolicy& policy ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Sets the collector policy of the state from a preset. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="preset">   The preset. </param>
+    ///
+    /// <returns>   A pointer to a const easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    const easy_lua* set_gc_preset(
+        EGcPreset preset ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the collector policy of the state. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   The policy. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    GcPolicy gc_policy() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   
+    /// Runs incremental collector steps until 'budget' elapsed or a cycle finished, meant for
+    /// idle windows. A step started before the budget elapsed is completed, so the budget can
+    /// be overrun by one step; longest_step tells how much.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="budget">   The time to spend. </param>
+    /// <param name="step_kb">  (Optional) The work per step in KBytes of allocation, zero for the smallest step. </param>
+    ///
+    /// <returns>   The work done. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    GcStep gc_step_for(
+        std::chrono::microseconds budget,
+        int32_t                   step_kb = 0 ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the statistics of the steps run by gc_step_for. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   The statistics. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    GcStats gc_stats() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Switches the JIT compiler of the state on or off or flushes its traces. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="mode"> The mode. </param>
+    ///
+    /// <returns>   Null if it fails, else a pointer to a const easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    const easy_lua* set_jit_mode(
+        EJitMode mode ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   
+    /// Switches the JIT compiler on or off for the lua function at 'stackpos' or flushes its
+    /// traces. Functions which are never worth compiling can be excluded this way.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="stackpos">     The stackpos of the function. </param>
+    /// <param name="mode">         The mode. </param>
+    /// <param name="recursive">    (Optional) Apply to the functions defined inside as well. </param>
+    ///
+    /// <returns>   Null if it fails, else a pointer to a const easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    const easy_lua* set_jit_mode(
+        int32_t  stackpos,
+        EJitMode mode,
+        bool     recursive = true ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Tunes the optimizer through jit.opt.start. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="options">  Options for controlling the operation. </param>
+    ///
+    /// <returns>   Null if it fails, else a pointer to a const easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    const easy_lua* set_jit_options(
+        const JitOptions& options ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   
+    /// Starts or stops collecting trace events through jit.attach. The collector is a lua
+    /// function called for every trace event, leave it off unless diagnosing.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="enable">   True to collect. </param>
+    ///
+    /// <returns>   Null if it fails, else a pointer to a const easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    const easy_lua* collect_jit_stats(
+        bool enable ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the trace statistics collected so far. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   The statistics, empty if nothing was collected. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    JitStats jit_stats() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Resets the trace statistics. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///-------------------------------------------------------------------------------------------------
+    void reset_jit_stats() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   
+    /// Wraps the function on top of the stack so its calls are counted and timed under 'name'
+    /// if Config::instrument_bindings is set, otherwise the stack is left alone. Called by the
+    /// export functions, custom registration code can use it the same way. The wrapper is a lua
+    /// function, instrumented functions can still yield; the time they spend suspended counts
+    /// as part of the call.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="name"> The binding name. </param>
+    ///
+    /// <returns>   A pointer to a const easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    const easy_lua* instrument_function(
+        const std::string_view& name ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   
+    /// Gets the statistics of the instrumented bindings, the slowest in total first. Scripts
+    /// get the same data from binding_stats() as table keyed by the binding name.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   The statistics, empty if nothing is instrumented. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    std::vector<BindingStats> binding_stats() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Resets the statistics of the instrumented bindings. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///-------------------------------------------------------------------------------------------------
+    void reset_binding_stats() const;
+
+private:
+    static easy_lua* setup(
+        lua_State*    l,
+        const Config& config );
+
+    easy_lua_allocator* attach_tracking_allocator() const;
+
 public:
     ///-------------------------------------------------------------------------------------------------
     /// <summary>   Creates a new userdata. </summary>
@@ -556,6 +1366,169 @@ public:
     template<typename T>
     T** new_userdata() const;
 
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   
+    /// Creates a new userdata constructing T inside the lua block. The block starts with a
+    /// pointer to the aligned object, so get_userdata works for both storage modes while the
+    /// object costs a single allocation.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="T">    Generic type parameter. </typeparam>
+    /// <param name="args"> The constructor arguments. </param>
+    ///
+    /// <returns>   Null if it fails, else the object. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<typename T, typename... Args>
+    T* new_userdata_value(
+        Args&&... args ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Pushes a new inline userdata and assigns its metatable. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="T">    Generic type parameter. </typeparam>
+    /// <param name="name"> The metatable name. </param>
+    /// <param name="args"> The constructor arguments. </param>
+    ///
+    /// <returns>   Null if it fails, else the object. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<typename T, typename... Args>
+    T* push_value(
+        const std::string_view& name,
+        Args&&...               args ) const;
+
+    template<typename T, typename... Args>
+    T* push_value(
+        const MetaTableArray& metatable,
+        Args&&...             args ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   
+    /// Runs the destructor of an inline userdata, meant for __gc. Userdata pointing to objects
+    /// owned elsewhere are left untouched.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="T">    Generic type parameter. </typeparam>
+    /// <param name="stackpos"> The stackpos. </param>
+    ///
+    /// <returns>   An int32_t. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<typename T>
+    int32_t destroy_userdata_value(
+        int32_t stackpos ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   
+    /// Pushes any C++ callable as a lua function. Argument and result conversions are generated
+    /// from its signature, captured state lives in an upvalue and std::tuple results are
+    /// returned as multiple values.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="F">    Generic callable type parameter. </typeparam>
+    /// <param name="callback"> The callable. </param>
+    ///
+    /// <returns>   Null if it fails, else a pointer to a const easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<typename F>
+    const easy_lua* push_function(
+        F&& callback ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Export any C++ callable, see push_function. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="F">    Generic callable type parameter. </typeparam>
+    /// <param name="name">     The name. </param>
+    /// <param name="callback"> The callable. </param>
+    ///
+    /// <returns>   Null if it fails, else a pointer to a const easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<typename F, typename = std::enable_if_t<!std::is_convertible_v<F, FnCallback>>>
+    const easy_lua* export_function(
+        const std::string_view& name,
+        F&&                     callback ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Calls the global function 'function' with 'args' converted by easy_lua_stack and converts
+    /// its first return value to R. The stack is left as it was found.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="R">        The result type, void to discard all results. </typeparam>
+    /// <typeparam name="Args">     The argument types. </typeparam>
+    /// <param name="function"> The global name of the function. </param>
+    /// <param name="args">     The arguments. </param>
+    ///
+    /// <returns>   The state, the error message on failure and the converted value. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<typename R = void, typename... Args>
+    easy_lua_result<R> call(
+        const std::string_view& function,
+        const Args&...          args ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Calls the function at 'stackpos' like call and stores the outcome in 'result'. The function
+    /// stays on the stack, so it can be called repeatedly without a global lookup. 'result' is
+    /// overwritten in place, reusing the capacity of its error string.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="R">        The result type, void to discard all results. </typeparam>
+    /// <typeparam name="Args">     The argument types. </typeparam>
+    /// <param name="stackpos"> The stackpos of the function. </param>
+    /// <param name="result">   [out] The result. </param>
+    /// <param name="args">     The arguments. </param>
+    ///
+    /// <returns>   The state of the call. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<typename R, typename... Args>
+    EState call_at(
+        int32_t             stackpos,
+        easy_lua_result<R>& result,
+        const Args&...      args ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Calls the global function 'function' once per input tuple. The function is resolved once,
+    /// every item gets its own protected call, so a failing item does not abort the batch.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="R">        The result type, void to discard all results. </typeparam>
+    /// <typeparam name="Args">     The argument types. </typeparam>
+    /// <param name="function"> The global name of the function. </param>
+    /// <param name="inputs">   The arguments of every call. </param>
+    /// <param name="count">    The number of calls. </param>
+    /// <param name="outputs">  [out] Preallocated space for 'count' results. </param>
+    ///
+    /// <returns>   The number of failed calls, 'count' if 'function' is not a function. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<typename R, typename... Args>
+    size_t call_batch(
+        const std::string_view&   function,
+        const std::tuple<Args...>* inputs,
+        size_t                    count,
+        easy_lua_result<R>*       outputs ) const;
+
+    template<typename R, typename... Args>
+    size_t call_batch(
+        const std::string_view&                 function,
+        const std::vector<std::tuple<Args...>>& inputs,
+        std::vector<easy_lua_result<R>>&        outputs ) const;
+
     ///-------------------------------------------------------------------------------------------------
     /// <summary>   Pushes a number. </summary>
     ///
@@ -616,6 +1589,44 @@ public:
         const MetaTableArray& metatable,
         T*                    data ) const;
 
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   
+    /// Pushes a std::vector, std::array, std::map, std::unordered_map or reflected struct as
+    /// table, nested containers included. Array parts are presized.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="T">    Generic type parameter. </typeparam>
+    /// <param name="value">    The value. </param>
+    ///
+    /// <returns>   Null if it fails, else a pointer to a const easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<typename T>
+    const easy_lua* push_table(
+        const T& value ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   
+    /// Reads the table at 'stackpos' into a container or reflected struct, see push_table. Every
+    /// element is validated, 'value' is only assigned if the whole table converts.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="T">    Generic type parameter. </typeparam>
+    /// <param name="stackpos">     The stackpos. </param>
+    /// <param name="value">        [out] The value. </param>
+    /// <param name="pop_value">    (Optional) True to pop value. </param>
+    ///
+    /// <returns>   True if it succeeds, false if it fails. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<typename T>
+    bool get_table(
+        int32_t stackpos,
+        T&      value,
+        bool    pop_value = false ) const;
+
     ///-------------------------------------------------------------------------------------------------
     /// <summary>   Gets a number. </summary>
     ///
@@ -675,9 +1686,34 @@ public:
         int32_t               stackpos,
         const MetaTableArray& metatable_data,
         bool                  pop_value = false ) const;
+};
 
-public:
-    static std::string script_directory;
+///-------------------------------------------------------------------------------------------------
+/// <summary>   The outcome of a typed call. </summary>
+///-------------------------------------------------------------------------------------------------
+template<typename R = void>
+struct easy_lua_result
+{
+    easy_lua::EState state = easy_lua::State_Success;
+    std::string      error;
+    R                value{};
+
+    explicit operator bool() const
+    {
+        return state == easy_lua::State_Success;
+    }
+};
+
+template<>
+struct easy_lua_result<void>
+{
+    easy_lua::EState state = easy_lua::State_Success;
+    std::string      error;
+
+    explicit operator bool() const
+    {
+        return state == easy_lua::State_Success;
+    }
 };
 
 template<typename T>
@@ -688,6 +1724,89 @@ T** easy_lua::new_userdata() const
     );
 }
 
+template<typename T, typename... Args>
+T* easy_lua::new_userdata_value(
+    Args&&... args ) const
+{
+    /// lua userdata blocks are only guaranteed to be aligned for a pointer.
+    constexpr auto padding = alignof( T ) > alignof( T* ) ? alignof( T ) - alignof( T* ) : 0;
+    constexpr auto length  = sizeof( T* ) + padding + sizeof( T );
+
+    const auto block = static_cast<T**>( lua_newuserdata( EASY_LUA_CAST_LUA( this ), length ) );
+    if( !block ) {
+        return nullptr;
+    }
+    *block = nullptr;
+
+    void*  storage = block + 1;
+    size_t space   = length - sizeof( T* );
+    if( !std::align( alignof( T ), sizeof( T ), storage, space ) ) {
+        return nullptr;
+    }
+    *block = new( storage ) T( std::forward<Args>( args )... );
+    return *block;
+}
+
+template<typename T, typename... Args>
+T* easy_lua::push_value(
+    const std::string_view& name,
+    Args&&...               args ) const
+{
+    if( name.empty() ) {
+        return nullptr;
+    }
+    const auto object = new_userdata_value<T>( std::forward<Args>( args )... );
+    if( object ) {
+        push_metatable( name );
+        lua_setmetatable( EASY_LUA_CAST_LUA( this ), -2 );
+    }
+    return object;
+}
+
+template<typename T, typename... Args>
+T* easy_lua::push_value(
+    const MetaTableArray& metatable,
+    Args&&...             args ) const
+{
+    const auto object = new_userdata_value<T>( std::forward<Args>( args )... );
+    if( object ) {
+        push_metatable( metatable );
+        lua_setmetatable( EASY_LUA_CAST_LUA( this ), -2 );
+    }
+    return object;
+}
+
+template<typename T>
+int32_t easy_lua::destroy_userdata_value(
+    const int32_t stackpos ) const
+{
+    if( is_userdata_inline( stackpos ) ) {
+        const auto block = static_cast<T**>( lua_touserdata( EASY_LUA_CAST_LUA( this ), stackpos ) );
+        ( *block )->~T();
+        *block = nullptr;
+    }
+    return 0;
+}
+
+template<typename F>
+const easy_lua* easy_lua::push_function(
+    F&& callback ) const
+{
+    easy_lua_function<std::decay_t<F>>::push( EASY_LUA_CAST_LUA( this ), std::forward<F>( callback ) );
+    return this;
+}
+
+template<typename F, typename>
+const easy_lua* easy_lua::export_function(
+    const std::string_view& name,
+    F&&                     callback ) const
+{
+    if( name.empty() ) {
+        return nullptr;
+    }
+    return push_function( std::forward<F>( callback ) )->instrument_function( name )->set_global( name );
+}
+
 template<typename T>
 const easy_lua* easy_lua::push_number(
     const T value ) const
@@ -715,7 +1834,7 @@ const easy_lua* easy_lua::push_userdata(
         auto created_data = new_userdata<T>();
         if( created_data ) {
             *created_data = data;
-            luaL_getmetatable( EASY_LUA_CAST_LUA( this ), name.data() );
+            push_metatable( name );
             lua_setmetatable( EASY_LUA_CAST_LUA( this ), -2 );
             return this;
         }
@@ -728,7 +1847,16 @@ const easy_lua* easy_lua::push_userdata(
     const MetaTableArray& metatable,
     T*                    data ) const
 {
-    return push_userdata( metatable[ 1 ], data );
+    if( data ) {
+        auto created_data = new_userdata<T>();
+        if( created_data ) {
+            *created_data = data;
+            push_metatable( metatable );
+            lua_setmetatable( EASY_LUA_CAST_LUA( this ), -2 );
+            return this;
+        }
+    }
+    return nullptr;
 }
 
 template<typename T>
@@ -774,19 +1902,25 @@ T* easy_lua::get_userdata(
     const bool              pop_value ) const
 {
     if( is_userdata( stackpos ) && !name.empty() ) {
-        const auto v = luaL_checkudata(
-            EASY_LUA_CAST_LUA( this ),
-            stackpos,
-            name.data()
-        );
-        if( v ) {
-            if( pop_value ) {
-                if( pop( 1 ) == this ) {
-                    return *reinterpret_cast<T**>( v );
-                }
+        /// Same behaviour as luaL_checkudata without requiring a NUL terminated name.
+        const auto l       = EASY_LUA_CAST_LUA( this );
+        const auto v       = lua_touserdata( l, stackpos );
+        auto       matches = false;
+        if( v && lua_getmetatable( l, stackpos ) ) {
+            push_metatable( name );
+            matches = lua_rawequal( l, -1, -2 ) != 0;
+            lua_pop( l, 2 );
+        }
+        if( !matches ) {
+            type_error( stackpos, name );
+            return nullptr;
+        }
+        if( pop_value ) {
+            if( pop( 1 ) == this ) {
+                return *reinterpret_cast<T**>( v );
             }
-            return *reinterpret_cast<T**>( v );
         }
+        return *reinterpret_cast<T**>( v );
     }
     return nullptr;
 }
@@ -797,5 +1931,162 @@ T* easy_lua::get_userdata(
     const MetaTableArray& metatable_data,
     const bool            pop_value ) const
 {
-    return get_userdata<T>( stackpos, metatable_data.at( 1 ), pop_value );
+    const auto l = EASY_LUA_CAST_LUA( this );
+    const auto v = lua_touserdata( l, stackpos );
+    if( !v || lua_islightuserdata( l, stackpos ) ) {
+        return nullptr;
+    }
+
+    auto matches = false;
+    if( lua_getmetatable( l, stackpos ) ) {
+        push_metatable( metatable_data );
+        matches = lua_rawequal( l, -1, -2 ) != 0;
+        lua_pop( l, 2 );
+    }
+    if( !matches ) {
+        /// Same behaviour as luaL_checkudata.
+        type_error( stackpos, metatable_data[ 1 ] );
+        return nullptr;
+    }
+
+    const auto data = *reinterpret_cast<T**>( v );
+    if( pop_value ) {
+        if( pop( 1 ) == this ) {
+            return data;
+        }
+    }
+    return data;
+}
+
+template<typename R, typename... Args>
+easy_lua_result<R> easy_lua::call(
+    const std::string_view& function,
+    const Args&...          args ) const
+{
+    const auto         l   = EASY_LUA_CAST_LUA( this );
+    const auto         top = lua_gettop( l );
+    easy_lua_result<R> result;
+    get_global( function );
+    if( !lua_isfunction( l, -1 ) ) {
+        result.state = State_Runtime;
+        result.error = "attempt to call '" + std::string( function ) + "' (not a function)";
+    }
+    else {
+        call_at( -1, result, args... );
+    }
+    lua_settop( l, top );
+    return result;
+}
+
+template<typename R, typename... Args>
+easy_lua::EState easy_lua::call_at(
+    int32_t             stackpos,
+    easy_lua_result<R>& result,
+    const Args&...      args ) const
+{
+    static_assert( !std::is_same_v<R, std::string_view> && !std::is_same_v<R, const char*>,
+                   "The result is popped before returning, use std::string" );
+
+    const auto l   = EASY_LUA_CAST_LUA( this );
+    const auto top = lua_gettop( l );
+    if( stackpos < 0 && stackpos > LUA_REGISTRYINDEX ) {
+        stackpos = top + stackpos + 1;
+    }
+    result.error.clear();
+    if( !lua_checkstack( l, static_cast<int32_t>( sizeof...( Args ) ) + 1 ) ) {
+        result.state = State_MemAlloc;
+        result.error = "stack overflow";
+        return result.state;
+    }
+
+    lua_pushvalue( l, stackpos );
+    const auto num_args = ( 0 + ... + easy_lua_stack<std::decay_t<Args>>::push( l, args ) );
+    result.state = pcall( num_args, std::is_void_v<R> ? 0 : 1, 0 );
+    if( result.state != State_Success ) {
+        result.error.assign( get_string_view( -1 ) );
+    }
+    else if constexpr( !std::is_void_v<R> ) {
+        using stack = easy_lua_stack<std::decay_t<R>>;
+        if( stack::check( l, -1 ) ) {
+            result.value = stack::get( l, -1 );
+        }
+        else {
+            result.state = State_Runtime;
+            result.error.append( "bad result (" ).append( stack::name ).append( " expected, got " )
+                        .append( luaL_typename( l, -1 ) ).append( ")" );
+        }
+    }
+    lua_settop( l, top );
+    return result.state;
+}
+
+template<typename R, typename... Args>
+size_t easy_lua::call_batch(
+    const std::string_view&    function,
+    const std::tuple<Args...>* inputs,
+    const size_t               count,
+    easy_lua_result<R>*        outputs ) const
+{
+    const auto l   = EASY_LUA_CAST_LUA( this );
+    const auto top = lua_gettop( l );
+    get_global( function );
+    if( !lua_isfunction( l, -1 ) ) {
+        lua_settop( l, top );
+        for( size_t i = 0; i < count; ++i ) {
+            outputs[ i ].state = State_Runtime;
+            outputs[ i ].error.assign( "attempt to call '" ).append( function ).append( "' (not a function)" );
+        }
+        return count;
+    }
+
+    const auto function_index = lua_gettop( l );
+    size_t     failed         = 0;
+    for( size_t i = 0; i < count; ++i ) {
+        const auto state = std::apply( [ this, function_index, &outputs, i ]( const Args&... args )
+        {
+            return call_at( function_index, outputs[ i ], args... );
+        }, inputs[ i ] );
+        if( state != State_Success ) {
+            ++failed;
+        }
+    }
+    lua_settop( l, top );
+    return failed;
+}
+
+template<typename R, typename... Args>
+size_t easy_lua::call_batch(
+    const std::string_view&                 function,
+    const std::vector<std::tuple<Args...>>& inputs,
+    std::vector<easy_lua_result<R>>&        outputs ) const
+{
+    if( outputs.size() < inputs.size() ) {
+        outputs.resize( inputs.size() );
+    }
+    return call_batch( function, inputs.data(), inputs.size(), outputs.data() );
+}
+
+template<typename T>
+const easy_lua* easy_lua::push_table(
+    const T& value ) const
+{
+    static_assert( easy_lua_has_read<T>::value, "Type T has to be a supported container or a reflected struct" );
+    easy_lua_stack<T>::push( EASY_LUA_CAST_LUA( this ), value );
+    return this;
+}
+
+template<typename T>
+bool easy_lua::get_table(
+    const int32_t stackpos,
+    T&            value,
+    const bool    pop_value ) const
+{
+    static_assert( easy_lua_has_read<T>::value, "Type T has to be a supported container or a reflected struct" );
+    const auto result = easy_lua_stack<T>::read( EASY_LUA_CAST_LUA( this ), stackpos, value );
+    if( pop_value ) {
+        if( pop( 1 ) == this ) {
+            return result;
+        }
+    }
+    return result;
 }
@@ -0,0 +1,260 @@
+#include "easy_lua_allocator.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+void* easy_lua_allocator::alloc(
+    void*        ud,
+    void*        ptr,
+    const size_t osize,
+    const size_t nsize )
+{
+    const auto allocator = static_cast<easy_lua_allocator*>( ud );
+    auto&      stats     = allocator->m_stats;
+    const auto old_size  = ptr ? osize : 0;
+    if( nsize == 0 ) {
+        if( ptr ) {
+            allocator->deallocate( ptr, osize );
+            stats.bytes_in_use -= std::min( osize, stats.bytes_in_use );
+        }
+        return nullptr;
+    }
+
+    if( nsize > old_size ) {
+        ++stats.allocations;
+        size_t bucket = 0;
+        while( bucket + 1 < easy_lua::MemoryStats::bucket_count && nsize > ( size_t( 16 ) << bucket ) ) {
+            ++bucket;
+        }
+        ++stats.buckets[ bucket ];
+
+        if( stats.limit != 0 && stats.bytes_in_use + ( nsize - old_size ) > stats.limit ) {
+            ++stats.failed_allocations;
+            return nullptr;
+        }
+    }
+
+    const auto block = ptr
+        ? allocator->reallocate( ptr, osize, nsize )
+        : allocator->allocate( nsize );
+    if( !block ) {
+        ++stats.failed_allocations;
+        return nullptr;
+    }
+
+    stats.bytes_in_use = stats.bytes_in_use - std::min( old_size, stats.bytes_in_use ) + nsize;
+    stats.peak_bytes   = std::max( stats.peak_bytes, stats.bytes_in_use );
+    return block;
+}
+
+size_t easy_lua_allocator::bytes_in_use() const
+{
+    return m_stats.bytes_in_use;
+}
+
+easy_lua::MemoryStats easy_lua_allocator::stats() const
+{
+    return m_stats;
+}
+
+void easy_lua_allocator::set_limit(
+    const size_t limit )
+{
+    m_stats.limit = limit;
+}
+
+void easy_lua_allocator::seed(
+    const size_t bytes )
+{
+    m_stats.bytes_in_use += bytes;
+    m_stats.peak_bytes    = std::max( m_stats.peak_bytes, m_stats.bytes_in_use );
+}
+
+lua_Alloc easy_lua_allocator::parent(
+    void** ud ) const
+{
+    *ud = nullptr;
+    return nullptr;
+}
+
+void* easy_lua_allocator::reallocate(
+    void*        ptr,
+    const size_t osize,
+    const size_t nsize )
+{
+    const auto block = allocate( nsize );
+    if( block ) {
+        std::memcpy( block, ptr, std::min( osize, nsize ) );
+        deallocate( ptr, osize );
+    }
+    return block;
+}
+
+easy_lua_size_class_allocator::~easy_lua_size_class_allocator()
+{
+    for( const auto slab : m_slabs ) {
+        std::free( slab );
+    }
+}
+
+void* easy_lua_size_class_allocator::allocate(
+    const size_t size )
+{
+    if( size > max_block_size ) {
+        return std::malloc( size );
+    }
+
+    const auto index = size_class( size );
+    if( const auto block = m_free_lists[ index ] ) {
+        m_free_lists[ index ] = block->next;
+        return block;
+    }
+
+    const auto block_size = ( index + 1 ) * granularity;
+    if( static_cast<size_t>( m_slab_end - m_slab_cursor ) < block_size ) {
+        /// The tail of the previous slab is lost, it is smaller than the largest size class.
+        const auto slab = static_cast<char*>( std::malloc( slab_size ) );
+        if( !slab ) {
+            return nullptr;
+        }
+        m_slabs.push_back( slab );
+        m_slab_cursor = slab;
+        m_slab_end    = slab + slab_size;
+    }
+
+    const auto block = m_slab_cursor;
+    m_slab_cursor += block_size;
+    return block;
+}
+
+void easy_lua_size_class_allocator::deallocate(
+    void*        ptr,
+    const size_t size )
+{
+    if( size > max_block_size ) {
+        std::free( ptr );
+        return;
+    }
+
+    const auto index = size_class( size );
+    const auto block = static_cast<FreeBlock*>( ptr );
+    block->next = m_free_lists[ index ];
+    m_free_lists[ index ] = block;
+}
+
+void* easy_lua_size_class_allocator::reallocate(
+    void*        ptr,
+    const size_t osize,
+    const size_t nsize )
+{
+    if( osize <= max_block_size && nsize <= max_block_size && size_class( osize ) == size_class( nsize ) ) {
+        return ptr;
+    }
+    const auto block = osize > max_block_size && nsize > max_block_size
+        ? std::realloc( ptr, nsize )
+        : easy_lua_allocator::reallocate( ptr, osize, nsize );
+
+    /// Lua assumes shrinking never fails, the old block is large enough. A large block kept
+    /// this way is later freed into the free list of its new size class.
+    return block || nsize > osize ? block : ptr;
+}
+
+size_t easy_lua_size_class_allocator::size_class(
+    const size_t size )
+{
+    return size == 0 ? 0 : ( size - 1 ) / granularity;
+}
+
+easy_lua_arena_allocator::~easy_lua_arena_allocator()
+{
+    for( const auto chunk : m_chunks ) {
+        std::free( chunk );
+    }
+}
+
+void* easy_lua_arena_allocator::allocate(
+    const size_t size )
+{
+    const auto aligned = align( size );
+    if( static_cast<size_t>( m_end - m_cursor ) < aligned ) {
+        const auto length = std::max( chunk_size, aligned );
+        const auto chunk  = static_cast<char*>( std::malloc( length ) );
+        if( !chunk ) {
+            return nullptr;
+        }
+        m_chunks.push_back( chunk );
+        m_cursor = chunk;
+        m_end    = chunk + length;
+    }
+
+    m_last    = m_cursor;
+    m_cursor += aligned;
+    return m_last;
+}
+
+void easy_lua_arena_allocator::deallocate(
+    void*        ptr,
+    const size_t )
+{
+    if( ptr == m_last ) {
+        m_cursor = m_last;
+        m_last   = nullptr;
+    }
+}
+
+void* easy_lua_arena_allocator::reallocate(
+    void*        ptr,
+    const size_t osize,
+    const size_t nsize )
+{
+    if( ptr == m_last && static_cast<size_t>( m_end - m_last ) >= align( nsize ) ) {
+        m_cursor = m_last + align( nsize );
+        return ptr;
+    }
+    if( align( nsize ) <= align( osize ) ) {
+        return ptr;
+    }
+    return easy_lua_allocator::reallocate( ptr, osize, nsize );
+}
+
+size_t easy_lua_arena_allocator::align(
+    const size_t size )
+{
+    return ( size + alignment - 1 ) & ~( alignment - 1 );
+}
+
+easy_lua_tracking_allocator::easy_lua_tracking_allocator(
+    const lua_Alloc parent,
+    void*           parent_ud )
+    : m_parent( parent )
+    , m_parent_ud( parent_ud )
+{
+}
+
+lua_Alloc easy_lua_tracking_allocator::parent(
+    void** ud ) const
+{
+    *ud = m_parent_ud;
+    return m_parent;
+}
+
+void* easy_lua_tracking_allocator::allocate(
+    const size_t size )
+{
+    return m_parent( m_parent_ud, nullptr, 0, size );
+}
+
+void easy_lua_tracking_allocator::deallocate(
+    void*        ptr,
+    const size_t size )
+{
+    m_parent( m_parent_ud, ptr, size, 0 );
+}
+
+void* easy_lua_tracking_allocator::reallocate(
+    void*        ptr,
+    const size_t osize,
+    const size_t nsize )
+{
+    return m_parent( m_parent_ud, ptr, osize, nsize );
+}
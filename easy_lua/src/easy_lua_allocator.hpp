@@ -0,0 +1,231 @@
+///-------------------------------------------------------------------------------------------------
+/// Author:             ReactiioN
+/// Created:            16.10.2026
+///
+/// Last modified by:   ReactiioN
+/// Last modified on:   16.10.2026
+///-------------------------------------------------------------------------------------------------
+///     Copyright (c) ReactiioN <https://reactiion.pw>. All rights reserved.
+///-------------------------------------------------------------------------------------------------
+/// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+/// Copyright (c) 2016-2017 ReactiioN <https://reactiion.pw>.
+///-------------------------------------------------------------------------------------------------
+#pragma once
+#include "easy_lua.hpp"
+
+class easy_lua_allocator
+{
+public:
+    virtual ~easy_lua_allocator() = default;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   The lua_Alloc entry point, 'ud' has to be an easy_lua_allocator. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="ud">       The allocator. </param>
+    /// <param name="ptr">      The block to resize or free, null for a new block. </param>
+    /// <param name="osize">    The old size of the block. </param>
+    /// <param name="nsize">    The new size of the block, zero to free it. </param>
+    ///
+    /// <returns>   Null if it fails or the block was freed, else the block. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    static void* alloc(
+        void*  ud,
+        void*  ptr,
+        size_t osize,
+        size_t nsize );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the number of bytes currently handed out to the state. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   A size_t. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    size_t bytes_in_use() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the allocation statistics. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   The statistics. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    easy_lua::MemoryStats stats() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Sets the hard cap of bytes_in_use, zero removes it. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="limit">    The limit in bytes. </param>
+    ///-------------------------------------------------------------------------------------------------
+    void set_limit(
+        size_t limit );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Accounts for blocks allocated before the allocator was installed. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="bytes">    The bytes already in use. </param>
+    ///-------------------------------------------------------------------------------------------------
+    void seed(
+        size_t bytes );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the allocator this one forwards to. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="ud">   [out] The user data of the parent allocator. </param>
+    ///
+    /// <returns>   Null if the allocator owns its blocks, else the parent allocator. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    virtual lua_Alloc parent(
+        void** ud ) const;
+
+protected:
+    virtual void* allocate(
+        size_t size ) = 0;
+
+    virtual void deallocate(
+        void*  ptr,
+        size_t size ) = 0;
+
+    virtual void* reallocate(
+        void*  ptr,
+        size_t osize,
+        size_t nsize );
+
+private:
+    easy_lua::MemoryStats m_stats;
+};
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// Serves blocks up to max_block_size from per size class free lists carved out of slabs,
+/// larger blocks go to malloc.
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+class easy_lua_size_class_allocator
+    : public easy_lua_allocator
+{
+public:
+    static constexpr size_t granularity    = 16;
+    static constexpr size_t max_block_size = 512;
+    static constexpr size_t slab_size      = 64 * 1024;
+
+    easy_lua_size_class_allocator() = default;
+    easy_lua_size_class_allocator( const easy_lua_size_class_allocator& ) = delete;
+    easy_lua_size_class_allocator& operator = ( const easy_lua_size_class_allocator& ) = delete;
+
+    ~easy_lua_size_class_allocator() override;
+
+protected:
+    void* allocate(
+        size_t size ) override;
+
+    void deallocate(
+        void*  ptr,
+        size_t size ) override;
+
+    void* reallocate(
+        void*  ptr,
+        size_t osize,
+        size_t nsize ) override;
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    static size_t size_class(
+        size_t size );
+
+private:
+    std::array<FreeBlock*, max_block_size / granularity> m_free_lists = {};
+    std::vector<void*>                                   m_slabs;
+    char*                                                m_slab_cursor = nullptr;
+    char*                                                m_slab_end    = nullptr;
+};
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// Bump allocator for throwaway states. Freed blocks are only reclaimed if they were the most
+/// recent allocation, everything else is released in one shot when the state is closed.
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+class easy_lua_arena_allocator
+    : public easy_lua_allocator
+{
+public:
+    static constexpr size_t alignment  = 16;
+    static constexpr size_t chunk_size = 256 * 1024;
+
+    easy_lua_arena_allocator() = default;
+    easy_lua_arena_allocator( const easy_lua_arena_allocator& ) = delete;
+    easy_lua_arena_allocator& operator = ( const easy_lua_arena_allocator& ) = delete;
+
+    ~easy_lua_arena_allocator() override;
+
+protected:
+    void* allocate(
+        size_t size ) override;
+
+    void deallocate(
+        void*  ptr,
+        size_t size ) override;
+
+    void* reallocate(
+        void*  ptr,
+        size_t osize,
+        size_t nsize ) override;
+
+private:
+    static size_t align(
+        size_t size );
+
+private:
+    std::vector<void*> m_chunks;
+    char*              m_cursor = nullptr;
+    char*              m_end    = nullptr;
+    char*              m_last   = nullptr;
+};
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// Forwards to the allocator a state was created with, installed through lua_setallocf so it
+/// also works on LuaJIT builds that reject lua_newstate with a custom allocator.
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+class easy_lua_tracking_allocator
+    : public easy_lua_allocator
+{
+public:
+    easy_lua_tracking_allocator(
+        lua_Alloc parent,
+        void*     parent_ud );
+
+    lua_Alloc parent(
+        void** ud ) const override;
+
+protected:
+    void* allocate(
+        size_t size ) override;
+
+    void deallocate(
+        void*  ptr,
+        size_t size ) override;
+
+    void* reallocate(
+        void*  ptr,
+        size_t osize,
+        size_t nsize ) override;
+
+private:
+    lua_Alloc m_parent;
+    void*     m_parent_ud;
+};
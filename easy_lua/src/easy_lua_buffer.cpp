@@ -0,0 +1,296 @@
+#include "easy_lua_buffer.hpp"
+#include <cstring>
+
+namespace {
+    /// The address of this variable is the registry key of the view metatable.
+    char metatable_key = 0;
+
+    struct View
+    {
+        const uint8_t*      data;
+        size_t              size;
+        std::weak_ptr<void> owner;
+    };
+
+    View* to_view(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        const auto view = static_cast<View*>( lua_touserdata( l, stackpos ) );
+        if( !view || lua_islightuserdata( l, stackpos ) || !lua_getmetatable( l, stackpos ) ) {
+            return nullptr;
+        }
+        lua_pushlightuserdata( l, &metatable_key );
+        lua_rawget( l, LUA_REGISTRYINDEX );
+        const auto matches = lua_rawequal( l, -1, -2 ) != 0;
+        lua_pop( l, 2 );
+        return matches ? view : nullptr;
+    }
+
+    /// Raises an error unless 'stackpos' is a view with a living owner.
+    View& check_view(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        const auto view = to_view( l, stackpos );
+        if( !view ) {
+            luaL_typerror( l, stackpos, "buffer" );
+        }
+        if( view->owner.expired() ) {
+            luaL_error( l, "buffer expired" );
+        }
+        return *view;
+    }
+
+    void push_view(
+        lua_State*                 l,
+        const uint8_t*             data,
+        size_t                     size,
+        const std::weak_ptr<void>& owner );
+
+    /// Translates the string.sub style range i..j into a 0-based offset and length.
+    void check_range(
+        lua_State*    l,
+        const View&   view,
+        const int32_t first_arg,
+        size_t&       offset,
+        size_t&       length )
+    {
+        const auto size  = static_cast<lua_Integer>( view.size );
+        auto       first = luaL_optinteger( l, first_arg, 1 );
+        auto       last  = luaL_optinteger( l, first_arg + 1, size );
+        if( first < 0 ) {
+            first += size + 1;
+        }
+        if( last < 0 ) {
+            last += size + 1;
+        }
+        if( first < 1 || last > size || first > last + 1 ) {
+            luaL_error( l, "buffer range %d..%d out of bounds (size %d)",
+                        static_cast<int32_t>( first ), static_cast<int32_t>( last ), static_cast<int32_t>( size ) );
+        }
+        offset = static_cast<size_t>( first - 1 );
+        length = static_cast<size_t>( last - first + 1 );
+    }
+
+    template<typename T>
+    int read_value(
+        lua_State* l )
+    {
+        const auto& view   = check_view( l, 1 );
+        const auto  offset = luaL_checkinteger( l, 2 );
+        if( offset < 0 || static_cast<size_t>( offset ) + sizeof( T ) > view.size ) {
+            return luaL_error( l, "buffer offset %d out of bounds (size %d)",
+                               static_cast<int32_t>( offset ), static_cast<int32_t>( view.size ) );
+        }
+        T value;
+        std::memcpy( &value, view.data + offset, sizeof( T ) );
+        lua_pushnumber( l, static_cast<lua_Number>( value ) );
+        return 1;
+    }
+
+    int view_index(
+        lua_State* l )
+    {
+        if( lua_type( l, 2 ) == LUA_TNUMBER ) {
+            const auto& view  = check_view( l, 1 );
+            const auto  index = lua_tointeger( l, 2 );
+            if( index < 1 || static_cast<size_t>( index ) > view.size ) {
+                return luaL_error( l, "buffer index %d out of bounds (size %d)",
+                                   static_cast<int32_t>( index ), static_cast<int32_t>( view.size ) );
+            }
+            lua_pushinteger( l, view.data[ index - 1 ] );
+            return 1;
+        }
+        lua_pushvalue( l, 2 );
+        lua_rawget( l, lua_upvalueindex( 1 ) );
+        return 1;
+    }
+
+    int view_length(
+        lua_State* l )
+    {
+        lua_pushinteger( l, static_cast<lua_Integer>( check_view( l, 1 ).size ) );
+        return 1;
+    }
+
+    int view_sub(
+        lua_State* l )
+    {
+        const auto& view   = check_view( l, 1 );
+        size_t      offset = 0;
+        size_t      length = 0;
+        check_range( l, view, 2, offset, length );
+        push_view( l, view.data + offset, length, view.owner );
+        return 1;
+    }
+
+    int view_tostring(
+        lua_State* l )
+    {
+        const auto& view   = check_view( l, 1 );
+        size_t      offset = 0;
+        size_t      length = 0;
+        check_range( l, view, 2, offset, length );
+        lua_pushlstring( l, reinterpret_cast<const char*>( view.data + offset ), length );
+        return 1;
+    }
+
+    int view_valid(
+        lua_State* l )
+    {
+        const auto view = to_view( l, 1 );
+        lua_pushboolean( l, view && !view->owner.expired() ? 1 : 0 );
+        return 1;
+    }
+
+    int view_address(
+        lua_State* l )
+    {
+        lua_pushlightuserdata( l, const_cast<uint8_t*>( check_view( l, 1 ).data ) );
+        return 1;
+    }
+
+    int view_describe(
+        lua_State* l )
+    {
+        const auto view = to_view( l, 1 );
+        if( !view || view->owner.expired() ) {
+            lua_pushliteral( l, "buffer (expired)" );
+        }
+        else {
+            lua_pushfstring( l, "buffer (%d bytes)", static_cast<int32_t>( view->size ) );
+        }
+        return 1;
+    }
+
+    int view_destroy(
+        lua_State* l )
+    {
+        static_cast<View*>( lua_touserdata( l, 1 ) )->~View();
+        return 0;
+    }
+
+    /// buf:ptr() is written in lua so the cast stays visible to the trace compiler.
+    constexpr char pointer_source[] =
+        "local address = ...\n"
+        "local ok, ffi = pcall( require, 'ffi' )\n"
+        "if not ok then return nil end\n"
+        "local cast = ffi.cast\n"
+        "return function( self ) return cast( 'const uint8_t*', address( self ) ) end\n";
+
+    void push_metatable(
+        lua_State* l )
+    {
+        lua_pushlightuserdata( l, &metatable_key );
+        lua_rawget( l, LUA_REGISTRYINDEX );
+        if( !lua_isnil( l, -1 ) ) {
+            return;
+        }
+        lua_pop( l, 1 );
+
+        const luaL_Reg methods[] = {
+            { "sub",      &view_sub },
+            { "tostring", &view_tostring },
+            { "valid",    &view_valid },
+            { "address",  &view_address },
+            { "u8",       &read_value<uint8_t> },
+            { "i8",       &read_value<int8_t> },
+            { "u16",      &read_value<uint16_t> },
+            { "i16",      &read_value<int16_t> },
+            { "u32",      &read_value<uint32_t> },
+            { "i32",      &read_value<int32_t> },
+            { "f32",      &read_value<float> },
+            { "f64",      &read_value<double> },
+            { nullptr,    nullptr }
+        };
+
+        lua_createtable( l, 0, 6 );
+        lua_createtable( l, 0, static_cast<int32_t>( std::size( methods ) ) );
+        for( auto method = methods; method->name; ++method ) {
+            lua_pushcfunction( l, method->func );
+            lua_setfield( l, -2, method->name );
+        }
+        if( luaL_loadbuffer( l, pointer_source, sizeof( pointer_source ) - 1, "=easy_lua_buffer" ) == 0 ) {
+            lua_pushcfunction( l, &view_address );
+            if( lua_pcall( l, 1, 1, 0 ) == 0 && lua_isfunction( l, -1 ) ) {
+                lua_setfield( l, -2, "ptr" );
+            }
+            else {
+                lua_pop( l, 1 );
+            }
+        }
+        else {
+            lua_pop( l, 1 );
+        }
+        lua_pushcclosure( l, &view_index, 1 );
+        lua_setfield( l, -2, "__index" );
+        lua_pushcfunction( l, &view_length );
+        lua_setfield( l, -2, "__len" );
+        lua_pushcfunction( l, &view_describe );
+        lua_setfield( l, -2, "__tostring" );
+        lua_pushcfunction( l, &view_destroy );
+        lua_setfield( l, -2, "__gc" );
+        lua_pushliteral( l, "buffer" );
+        lua_setfield( l, -2, "__metatable" );
+
+        lua_pushlightuserdata( l, &metatable_key );
+        lua_pushvalue( l, -2 );
+        lua_rawset( l, LUA_REGISTRYINDEX );
+    }
+
+    void push_view(
+        lua_State*                 l,
+        const uint8_t*             data,
+        const size_t               size,
+        const std::weak_ptr<void>& owner )
+    {
+        new( lua_newuserdata( l, sizeof( View ) ) ) View{ data, size, owner };
+        push_metatable( l );
+        lua_setmetatable( l, -2 );
+    }
+}
+
+easy_lua_buffer::Owner::Owner()
+    : m_token( std::make_shared<char>( 0 ) )
+{
+}
+
+void easy_lua_buffer::Owner::reset()
+{
+    m_token = std::make_shared<char>( 0 );
+}
+
+const easy_lua* easy_lua_buffer::push(
+    const easy_lua* lua,
+    const void*     data,
+    const size_t    size,
+    const Owner&    owner )
+{
+    if( !data && size != 0 ) {
+        return nullptr;
+    }
+    push_view( EASY_LUA_CAST_LUA( lua ), static_cast<const uint8_t*>( data ), size, owner.m_token );
+    return lua;
+}
+
+bool easy_lua_buffer::is_buffer(
+    const easy_lua* lua,
+    const int32_t   stackpos )
+{
+    return to_view( EASY_LUA_CAST_LUA( lua ), stackpos ) != nullptr;
+}
+
+const uint8_t* easy_lua_buffer::get(
+    const easy_lua* lua,
+    const int32_t   stackpos,
+    size_t&         size )
+{
+    const auto view = to_view( EASY_LUA_CAST_LUA( lua ), stackpos );
+    if( !view || view->owner.expired() ) {
+        size = 0;
+        return nullptr;
+    }
+    size = view->size;
+    return view->data;
+}
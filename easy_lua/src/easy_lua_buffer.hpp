@@ -0,0 +1,110 @@
+///-------------------------------------------------------------------------------------------------
+/// Author:             ReactiioN
+/// Created:            16.10.2026
+///
+/// Last modified by:   ReactiioN
+/// Last modified on:   16.10.2026
+///-------------------------------------------------------------------------------------------------
+///     Copyright (c) ReactiioN <https://reactiion.pw>. All rights reserved.
+///-------------------------------------------------------------------------------------------------
+/// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+/// Copyright (c) 2016-2017 ReactiioN <https://reactiion.pw>.
+///-------------------------------------------------------------------------------------------------
+#pragma once
+#include "easy_lua.hpp"
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// Read-only views of C++ memory handed to scripts without copying. A view stays usable as long
+/// as the Owner it was pushed with is alive and not reset, afterwards every access raises an
+/// error. In lua:
+///     #buf, buf[ i ]                  size and byte i (1-based)
+///     buf:sub( i [, j] )              a view of bytes i..j sharing the owner
+///     buf:tostring( [i [, j]] )       a copy as lua string
+///     buf:u8( offset ) ... buf:f64()  native endian reads at a 0-based byte offset, also
+///                                     i8, u16, i16, u32, i32, f32
+///     buf:valid()                     false once the owner is gone
+///     buf:ptr()                       a const uint8_t* cdata for FFI loops (LuaJIT)
+/// The cdata pointer is not checked, it must not be used after the owner is gone.
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+class easy_lua_buffer
+{
+public:
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Ties views to the lifetime of the memory. Destroy or reset it on the thread running the
+    /// state before the memory goes away.
+    /// </summary>
+    ///-------------------------------------------------------------------------------------------------
+    class Owner
+    {
+        friend class easy_lua_buffer;
+
+    public:
+        Owner();
+        Owner( const Owner& ) = delete;
+        Owner& operator = ( const Owner& ) = delete;
+
+        ///-------------------------------------------------------------------------------------------------
+        /// <summary>   Invalidates every view pushed with this owner so far. </summary>
+        ///
+        /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+        ///-------------------------------------------------------------------------------------------------
+        void reset();
+
+    private:
+        std::shared_ptr<char> m_token;
+    };
+
+public:
+    easy_lua_buffer() = delete;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Pushes a view of 'size' bytes at 'data'. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">      The lua. </param>
+    /// <param name="data">     The memory. </param>
+    /// <param name="size">     The size in bytes. </param>
+    /// <param name="owner">    The owner of the memory. </param>
+    ///
+    /// <returns>   Null if it fails, else a pointer to a const easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    static const easy_lua* push(
+        const easy_lua* lua,
+        const void*     data,
+        size_t          size,
+        const Owner&    owner );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Query if 'stackpos' is a buffer view. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">      The lua. </param>
+    /// <param name="stackpos"> The stackpos. </param>
+    ///
+    /// <returns>   True if it is, false if not. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    static bool is_buffer(
+        const easy_lua* lua,
+        int32_t         stackpos );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the memory of the view at 'stackpos'. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">      The lua. </param>
+    /// <param name="stackpos"> The stackpos. </param>
+    /// <param name="size">     [out] The size in bytes. </param>
+    ///
+    /// <returns>   Null if it is no view or the owner is gone, else the memory. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    static const uint8_t* get(
+        const easy_lua* lua,
+        int32_t         stackpos,
+        size_t&         size );
+};
@@ -0,0 +1,319 @@
+#include "easy_lua_bytecode_cache.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <thread>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr char     bytecode_magic[ 4 ] = { 'E', 'L', 'B', 'C' };
+    constexpr uint32_t bytecode_version    = 1;
+
+    uint64_t fnv1a(
+        const char*  data,
+        const size_t size )
+    {
+        auto hash = 14695981039346656037ull;
+        for( size_t i = 0; i < size; ++i ) {
+            hash ^= static_cast<uint8_t>( data[ i ] );
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    easy_lua::EState to_state(
+        const int32_t result )
+    {
+        switch( result ) {
+        case 0:
+            return easy_lua::State_Success;
+        case LUA_ERRSYNTAX:
+            return easy_lua::State_Syntax;
+        case LUA_ERRMEM:
+            return easy_lua::State_MemAlloc;
+        case LUA_ERRFILE:
+            return easy_lua::State_File;
+        default:
+            break;
+        }
+        return easy_lua::State_Runtime;
+    }
+
+    /// Loaded bytecode is not verified, only files nobody else can have written are read or
+    /// replaced. Owned by the effective user and not writable by group or others, on Windows
+    /// the ACLs of the directory are trusted instead.
+    bool trusted(
+        const std::string& path,
+        const bool         directory )
+    {
+#ifdef _WIN32
+        static_cast<void>( path );
+        static_cast<void>( directory );
+        return true;
+#else
+        struct stat info = {};
+        if( lstat( path.c_str(), &info ) != 0 ) {
+            return false;
+        }
+        return ( directory ? S_ISDIR( info.st_mode ) : S_ISREG( info.st_mode ) )
+            && info.st_uid == geteuid()
+            && ( info.st_mode & ( S_IWGRP | S_IWOTH ) ) == 0;
+#endif
+    }
+
+    /// Unique per process, thread and call, so concurrent writers never share a temporary file.
+    std::string temp_path(
+        const std::string& target )
+    {
+        static std::atomic<uint64_t> counter{ 0 };
+#ifdef _WIN32
+        const auto pid = static_cast<unsigned long long>( _getpid() );
+#else
+        const auto pid = static_cast<unsigned long long>( getpid() );
+#endif
+        char suffix[ 80 ] = {};
+        snprintf(
+            suffix,
+            sizeof( suffix ),
+            ".%llx.%llx.%llx.tmp",
+            pid,
+            static_cast<unsigned long long>( std::hash<std::thread::id>()( std::this_thread::get_id() ) ),
+            static_cast<unsigned long long>( counter.fetch_add( 1, std::memory_order_relaxed ) )
+        );
+        return target + suffix;
+    }
+
+    int bytecode_writer(
+        lua_State*,
+        const void*  p,
+        const size_t sz,
+        void*        ud )
+    {
+        const auto data = static_cast<const char*>( p );
+        static_cast<std::vector<char>*>( ud )->insert(
+            static_cast<std::vector<char>*>( ud )->end(),
+            data,
+            data + sz
+        );
+        return 0;
+    }
+}
+
+easy_lua_bytecode_cache* easy_lua_bytecode_cache::shared()
+{
+    static easy_lua_bytecode_cache cache;
+    return &cache;
+}
+
+easy_lua::EState easy_lua_bytecode_cache::load(
+    const easy_lua*         lua,
+    const std::string_view& file )
+{
+    const auto l = EASY_LUA_CAST_LUA( lua );
+    const std::string path( file );
+    const auto chunk_name = "@" + path;
+
+    std::error_code ec;
+    const auto write_time = std::filesystem::last_write_time( path, ec );
+
+    std::ifstream stream( path, std::ios::binary );
+    if( ec || !stream ) {
+        return to_state( luaL_loadfile( l, path.c_str() ) );
+    }
+    const std::string source(
+        ( std::istreambuf_iterator<char>( stream ) ),
+        std::istreambuf_iterator<char>()
+    );
+
+    Entry expected{
+        static_cast<int64_t>( write_time.time_since_epoch().count() ),
+        fnv1a( source.data(), source.size() ),
+        nullptr
+    };
+
+    std::shared_ptr<const std::vector<char>> bytecode;
+    std::string disk_directory;
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        if( !m_enabled ) {
+            return to_state( luaL_loadbuffer( l, source.data(), source.size(), chunk_name.c_str() ) );
+        }
+        const auto it = m_entries.find( path );
+        if( it != m_entries.end() && it->second.mtime == expected.mtime && it->second.hash == expected.hash ) {
+            bytecode = it->second.bytecode;
+        }
+        disk_directory = m_disk_directory;
+    }
+
+    if( !bytecode && !disk_directory.empty() ) {
+        Entry entry;
+        if( load_from_disk( disk_directory, path, expected, entry ) ) {
+            bytecode = entry.bytecode;
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_entries[ path ] = std::move( entry );
+        }
+    }
+
+    if( bytecode ) {
+        const auto result = luaL_loadbuffer( l, bytecode->data(), bytecode->size(), chunk_name.c_str() );
+        if( result == 0 ) {
+            return easy_lua::State_Success;
+        }
+        /// The cached chunk is unusable (e.g. dumped by another LuaJIT build), compile the source.
+        lua_pop( l, 1 );
+    }
+
+    const auto result = luaL_loadbuffer( l, source.data(), source.size(), chunk_name.c_str() );
+    if( result != 0 ) {
+        return to_state( result );
+    }
+
+    auto dumped = std::make_shared<std::vector<char>>();
+    dumped->reserve( source.size() );
+    if( lua_dump( l, bytecode_writer, dumped.get() ) != 0 || dumped->empty() ) {
+        return easy_lua::State_Success;
+    }
+
+    expected.bytecode = std::move( dumped );
+    if( !disk_directory.empty() ) {
+        store_to_disk( disk_directory, path, expected );
+    }
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_entries[ path ] = std::move( expected );
+    return easy_lua::State_Success;
+}
+
+void easy_lua_bytecode_cache::set_enabled(
+    const bool enabled )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_enabled = enabled;
+}
+
+bool easy_lua_bytecode_cache::is_enabled() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    return m_enabled;
+}
+
+void easy_lua_bytecode_cache::set_disk_directory(
+    const std::string& directory )
+{
+    if( !directory.empty() ) {
+        std::error_code ec;
+        if( std::filesystem::create_directories( directory, ec ) ) {
+            std::filesystem::permissions( directory, std::filesystem::perms::owner_all, std::filesystem::perm_options::replace, ec );
+        }
+    }
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_disk_directory = directory;
+}
+
+void easy_lua_bytecode_cache::clear()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_entries.clear();
+}
+
+size_t easy_lua_bytecode_cache::size() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    return m_entries.size();
+}
+
+bool easy_lua_bytecode_cache::load_from_disk(
+    const std::string& directory,
+    const std::string& file,
+    const Entry&       expected,
+    Entry&             entry )
+{
+    const auto path = disk_path( directory, file );
+    if( !trusted( directory, true ) || !trusted( path, false ) ) {
+        return false;
+    }
+    std::ifstream stream( path, std::ios::binary );
+    if( !stream ) {
+        return false;
+    }
+
+    char     magic[ 4 ] = {};
+    uint32_t version    = 0;
+    int64_t  mtime      = 0;
+    uint64_t hash       = 0;
+    stream.read( magic, sizeof( magic ) );
+    stream.read( reinterpret_cast<char*>( &version ), sizeof( version ) );
+    stream.read( reinterpret_cast<char*>( &mtime ), sizeof( mtime ) );
+    stream.read( reinterpret_cast<char*>( &hash ), sizeof( hash ) );
+    if( !stream
+        || std::memcmp( magic, bytecode_magic, sizeof( magic ) ) != 0
+        || version != bytecode_version
+        || mtime != expected.mtime
+        || hash != expected.hash ) {
+        return false;
+    }
+
+    auto bytecode = std::make_shared<std::vector<char>>(
+        ( std::istreambuf_iterator<char>( stream ) ),
+        std::istreambuf_iterator<char>()
+    );
+    if( bytecode->empty() ) {
+        return false;
+    }
+
+    entry.mtime    = mtime;
+    entry.hash     = hash;
+    entry.bytecode = std::move( bytecode );
+    return true;
+}
+
+void easy_lua_bytecode_cache::store_to_disk(
+    const std::string& directory,
+    const std::string& file,
+    const Entry&       entry )
+{
+    if( !trusted( directory, true ) ) {
+        return;
+    }
+    const auto target = disk_path( directory, file );
+    const auto temp   = temp_path( target );
+    {
+        std::ofstream stream( temp, std::ios::binary | std::ios::trunc );
+        if( !stream ) {
+            return;
+        }
+        stream.write( bytecode_magic, sizeof( bytecode_magic ) );
+        stream.write( reinterpret_cast<const char*>( &bytecode_version ), sizeof( bytecode_version ) );
+        stream.write( reinterpret_cast<const char*>( &entry.mtime ), sizeof( entry.mtime ) );
+        stream.write( reinterpret_cast<const char*>( &entry.hash ), sizeof( entry.hash ) );
+        stream.write( entry.bytecode->data(), static_cast<std::streamsize>( entry.bytecode->size() ) );
+        if( !stream ) {
+            return;
+        }
+    }
+
+    /// Rename so concurrent processes never observe a partially written chunk.
+    std::error_code ec;
+    std::filesystem::rename( temp, target, ec );
+    if( ec ) {
+        std::filesystem::remove( temp, ec );
+    }
+}
+
+std::string easy_lua_bytecode_cache::disk_path(
+    const std::string& directory,
+    const std::string& file )
+{
+    char name[ 32 ] = {};
+    snprintf( name, sizeof( name ), "%016llx.elbc", static_cast<unsigned long long>( fnv1a( file.data(), file.size() ) ) );
+    return ( std::filesystem::path( directory ) / name ).string();
+}
@@ -0,0 +1,144 @@
+///-------------------------------------------------------------------------------------------------
+/// Author:             ReactiioN
+/// Created:            16.10.2026
+///
+/// Last modified by:   ReactiioN
+/// Last modified on:   16.10.2026
+///-------------------------------------------------------------------------------------------------
+///     Copyright (c) ReactiioN <https://reactiion.pw>. All rights reserved.
+///-------------------------------------------------------------------------------------------------
+/// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+/// Copyright (c) 2016-2017 ReactiioN <https://reactiion.pw>.
+///-------------------------------------------------------------------------------------------------
+#pragma once
+#include "easy_lua.hpp"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+class easy_lua_bytecode_cache
+{
+public:
+    struct Entry
+    {
+        /// <summary>
+        /// The last write time of the source file.
+        /// </summary>
+        int64_t mtime;
+        /// <summary>
+        /// The FNV-1a hash of the source file contents.
+        /// </summary>
+        uint64_t hash;
+        /// <summary>
+        /// The lua_dump output of the compiled chunk.
+        /// </summary>
+        std::shared_ptr<const std::vector<char>> bytecode;
+    };
+
+public:
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Creates a private cache, see easy_lua::Config::bytecode_cache. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///-------------------------------------------------------------------------------------------------
+    easy_lua_bytecode_cache() = default;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the process wide bytecode cache. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   The bytecode cache. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    static easy_lua_bytecode_cache* shared();
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Loads a file as a function on top of the stack. The compiled chunk is reused as long as the
+    /// path, last write time and content hash match the cached entry.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">  The lua state to load the chunk into. </param>
+    /// <param name="file"> The file. </param>
+    ///
+    /// <returns>   An EState. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    easy_lua::EState load(
+        const easy_lua*         lua,
+        const std::string_view& file );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Enables or disables the cache. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="enabled">  True to enable. </param>
+    ///-------------------------------------------------------------------------------------------------
+    void set_enabled(
+        bool enabled );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Query if the cache is enabled. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   True if enabled, false if not. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    bool is_enabled() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Sets the directory compiled chunks are persisted to. An empty directory keeps the cache in
+    /// memory only. Bytecode is loaded without verification, crafted bytecode can corrupt
+    /// memory, so the directory must only be writable by the user running the process. A
+    /// missing directory is created owner-only, and on POSIX the cache ignores it while it or
+    /// an entry is owned by another user or writable by group or others.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="directory">    Pathname of the directory. </param>
+    ///-------------------------------------------------------------------------------------------------
+    void set_disk_directory(
+        const std::string& directory );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Removes all in-memory entries. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///-------------------------------------------------------------------------------------------------
+    void clear();
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the number of in-memory entries. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   A size_t. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    size_t size() const;
+
+private:
+    static bool load_from_disk(
+        const std::string& directory,
+        const std::string& file,
+        const Entry&       expected,
+        Entry&             entry );
+
+    static void store_to_disk(
+        const std::string& directory,
+        const std::string& file,
+        const Entry&       entry );
+
+    static std::string disk_path(
+        const std::string& directory,
+        const std::string& file );
+
+private:
+    mutable std::mutex                     m_mutex;
+    bool                                   m_enabled = true;
+    std::string                            m_disk_directory;
+    std::unordered_map<std::string, Entry> m_entries;
+};
@@ -0,0 +1,575 @@
+///-------------------------------------------------------------------------------------------------
+/// Author:             ReactiioN
+/// Created:            16.10.2026
+///
+/// Last modified by:   ReactiioN
+/// Last modified on:   16.10.2026
+///-------------------------------------------------------------------------------------------------
+///     Copyright (c) ReactiioN <https://reactiion.pw>. All rights reserved.
+///-------------------------------------------------------------------------------------------------
+/// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+/// Copyright (c) 2016-2017 ReactiioN <https://reactiion.pw>.
+///-------------------------------------------------------------------------------------------------
+#pragma once
+#include "easy_lua.hpp"
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// Registers a C++ class from member pointers known at compile time:
+///
+///     easy_lua_class_binder<vec3>( lua, lua_vec3 )
+///         .constructor<float, float, float>()
+///         .method<&vec3::length>( "length" )
+///         .property<&vec3::x>( "x" )
+///         .property<&vec3::get_y, &vec3::set_y>( "y" )
+///         .commit();
+///
+/// Methods, accessors and constructors are plain template instantiations, no per binding state
+/// is allocated. Every generated function holds the metatable as upvalue and validates 'self'
+/// by comparing metatables instead of looking the metatable name up in the registry.
+/// Constructed objects live inline in their userdata (new_userdata_value) and are destroyed by
+/// the generated __gc, pointers pushed from C++ are borrowed. Both start with the object
+/// pointer, get_userdata keeps working on them.
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+template<typename T>
+class easy_lua_class_binder
+{
+public:
+    struct Accessor
+    {
+        /// <summary>
+        /// Pushes the property of the object, null if write only.
+        /// </summary>
+        int32_t( *get )( lua_State*, T* );
+        /// <summary>
+        /// Assigns the value at the given stackpos to the property, null if read only.
+        /// </summary>
+        void( *set )( lua_State*, T*, int32_t );
+    };
+
+public:
+    easy_lua_class_binder(
+        const easy_lua*         lua,
+        const std::string_view& global_name,
+        const std::string_view& metatable_name );
+
+    easy_lua_class_binder(
+        const easy_lua*                 lua,
+        const easy_lua::MetaTableArray& metatable_data );
+
+    easy_lua_class_binder( const easy_lua_class_binder& ) = delete;
+    easy_lua_class_binder& operator = ( const easy_lua_class_binder& ) = delete;
+
+    ~easy_lua_class_binder();
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Registers 'Global.new( ... )' and 'Global( ... )'. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="Args"> The constructor argument types. </typeparam>
+    ///
+    /// <returns>   This binder. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<typename... Args>
+    easy_lua_class_binder& constructor();
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Registers a member function. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="Method">   The member function pointer. </typeparam>
+    /// <param name="name"> The name. </param>
+    ///
+    /// <returns>   This binder. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<auto Method>
+    easy_lua_class_binder& method(
+        const std::string_view& name );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Registers a property. A data member is readable and writable (unless const), a member
+    /// function is a read only getter.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="Member">   The data member or getter pointer. </typeparam>
+    /// <param name="name"> The name. </param>
+    ///
+    /// <returns>   This binder. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<auto Member>
+    easy_lua_class_binder& property(
+        const std::string_view& name );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Registers a property backed by a getter and a setter. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="Getter">   The getter pointer. </typeparam>
+    /// <typeparam name="Setter">   The setter pointer. </typeparam>
+    /// <param name="name"> The name. </param>
+    ///
+    /// <returns>   This binder. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<auto Getter, auto Setter>
+    easy_lua_class_binder& property(
+        const std::string_view& name );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Installs __index, __newindex, __gc and the global table. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   Null if it fails, else a pointer to a const easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    const easy_lua* commit();
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Pushes an object owned by C++, lua never deletes it. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">              The lua. </param>
+    /// <param name="metatable_name">   Name of the metatable. </param>
+    /// <param name="object">           [in,out] If non-null, the object. </param>
+    ///
+    /// <returns>   Null if it fails, else a pointer to a const easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    static const easy_lua* push(
+        const easy_lua*         lua,
+        const std::string_view& metatable_name,
+        T*                      object );
+
+    static const easy_lua* push(
+        const easy_lua*                 lua,
+        const easy_lua::MetaTableArray& metatable,
+        T*                              object );
+
+private:
+    template<typename R, typename Tuple>
+    struct invoker_of;
+
+    template<typename R, typename... Args>
+    struct invoker_of<R, std::tuple<Args...>>
+    {
+        using type = easy_lua_invoker<R, Args...>;
+    };
+
+    template<typename M>
+    struct member_of;
+
+    template<typename M, typename C>
+    struct member_of<M C::*>
+    {
+        using type = M;
+    };
+
+    static T* self(
+        lua_State*    l,
+        int32_t       stackpos,
+        int32_t       metatable );
+
+    template<auto Method>
+    static int method_closure(
+        lua_State* l );
+
+    template<int32_t First, typename... Args>
+    static int constructor_closure(
+        lua_State* l );
+
+    template<auto Member>
+    static int32_t member_get(
+        lua_State* l,
+        T*         object );
+
+    template<auto Member>
+    static void member_set(
+        lua_State*    l,
+        T*            object,
+        int32_t       stackpos );
+
+    template<auto Getter>
+    static int32_t getter_get(
+        lua_State* l,
+        T*         object );
+
+    template<auto Setter>
+    static void setter_set(
+        lua_State*    l,
+        T*            object,
+        int32_t       stackpos );
+
+    static int index(
+        lua_State* l );
+
+    static int new_index(
+        lua_State* l );
+
+    static int gc(
+        lua_State* l );
+
+    void add_method(
+        const std::string_view& name,
+        lua_CFunction           function ) const;
+
+    void add_property(
+        const std::string_view& name,
+        const Accessor*         accessor ) const;
+
+    template<auto Member>
+    static constexpr Accessor member_accessor = {
+        &member_get<Member>,
+        std::is_const_v<typename member_of<decltype( Member )>::type> ? nullptr : &member_set<Member>
+    };
+
+    template<auto Getter>
+    static constexpr Accessor getter_accessor = { &getter_get<Getter>, nullptr };
+
+    template<auto Getter, auto Setter>
+    static constexpr Accessor getter_setter_accessor = { &getter_get<Getter>, &setter_set<Setter> };
+
+private:
+    lua_State*  m_lua;
+    std::string m_global_name;
+    int32_t     m_metatable  = LUA_NOREF;
+    int32_t     m_methods    = LUA_NOREF;
+    int32_t     m_properties = LUA_NOREF;
+    int32_t     m_global     = LUA_NOREF;
+    int32_t     m_call       = LUA_NOREF;
+};
+
+template<typename T>
+easy_lua_class_binder<T>::easy_lua_class_binder(
+    const easy_lua*         lua,
+    const std::string_view& global_name,
+    const std::string_view& metatable_name )
+    : m_lua( EASY_LUA_CAST_LUA( lua ) )
+    , m_global_name( global_name )
+{
+    const std::string name( metatable_name );
+    luaL_newmetatable( m_lua, name.c_str() );
+    /// Named in the errors of methods called on a wrong 'self'.
+    lua_pushlstring( m_lua, name.data(), name.size() );
+    lua_setfield( m_lua, -2, "__name" );
+    m_metatable = luaL_ref( m_lua, LUA_REGISTRYINDEX );
+    lua_newtable( m_lua );
+    m_methods = luaL_ref( m_lua, LUA_REGISTRYINDEX );
+    lua_newtable( m_lua );
+    m_properties = luaL_ref( m_lua, LUA_REGISTRYINDEX );
+    lua_newtable( m_lua );
+    m_global = luaL_ref( m_lua, LUA_REGISTRYINDEX );
+}
+
+template<typename T>
+easy_lua_class_binder<T>::easy_lua_class_binder(
+    const easy_lua*                 lua,
+    const easy_lua::MetaTableArray& metatable_data )
+    : easy_lua_class_binder( lua, metatable_data[ 0 ], metatable_data[ 1 ] )
+{
+    lua_pushlightuserdata( m_lua, easy_lua::metatable_key( metatable_data ) );
+    lua_rawgeti( m_lua, LUA_REGISTRYINDEX, m_metatable );
+    lua_rawset( m_lua, LUA_REGISTRYINDEX );
+}
+
+template<typename T>
+easy_lua_class_binder<T>::~easy_lua_class_binder()
+{
+    for( const auto ref : { m_metatable, m_methods, m_properties, m_global, m_call } ) {
+        luaL_unref( m_lua, LUA_REGISTRYINDEX, ref );
+    }
+}
+
+template<typename T>
+template<typename... Args>
+easy_lua_class_binder<T>& easy_lua_class_binder<T>::constructor()
+{
+    lua_rawgeti( m_lua, LUA_REGISTRYINDEX, m_global );
+    lua_rawgeti( m_lua, LUA_REGISTRYINDEX, m_metatable );
+    lua_pushcclosure( m_lua, &constructor_closure<1, Args...>, 1 );
+    lua_setfield( m_lua, -2, "new" );
+    lua_pop( m_lua, 1 );
+
+    /// __call receives the global table as first argument.
+    luaL_unref( m_lua, LUA_REGISTRYINDEX, m_call );
+    lua_rawgeti( m_lua, LUA_REGISTRYINDEX, m_metatable );
+    lua_pushcclosure( m_lua, &constructor_closure<2, Args...>, 1 );
+    m_call = luaL_ref( m_lua, LUA_REGISTRYINDEX );
+    return *this;
+}
+
+template<typename T>
+template<auto Method>
+easy_lua_class_binder<T>& easy_lua_class_binder<T>::method(
+    const std::string_view& name )
+{
+    add_method( name, &method_closure<Method> );
+    return *this;
+}
+
+template<typename T>
+template<auto Member>
+easy_lua_class_binder<T>& easy_lua_class_binder<T>::property(
+    const std::string_view& name )
+{
+    if constexpr( std::is_member_object_pointer_v<decltype( Member )> ) {
+        add_property( name, &member_accessor<Member> );
+    }
+    else {
+        add_property( name, &getter_accessor<Member> );
+    }
+    return *this;
+}
+
+template<typename T>
+template<auto Getter, auto Setter>
+easy_lua_class_binder<T>& easy_lua_class_binder<T>::property(
+    const std::string_view& name )
+{
+    add_property( name, &getter_setter_accessor<Getter, Setter> );
+    return *this;
+}
+
+template<typename T>
+const easy_lua* easy_lua_class_binder<T>::commit()
+{
+    if( m_global_name.empty() ) {
+        return nullptr;
+    }
+
+    lua_rawgeti( m_lua, LUA_REGISTRYINDEX, m_metatable );
+    for( const auto& [ name, function ] : {
+        std::make_pair( "__index", &index ),
+        std::make_pair( "__newindex", &new_index ) } ) {
+        lua_rawgeti( m_lua, LUA_REGISTRYINDEX, m_metatable );
+        lua_rawgeti( m_lua, LUA_REGISTRYINDEX, m_methods );
+        lua_rawgeti( m_lua, LUA_REGISTRYINDEX, m_properties );
+        lua_pushcclosure( m_lua, function, 3 );
+        lua_setfield( m_lua, -2, name );
+    }
+    lua_pushcfunction( m_lua, &gc );
+    lua_setfield( m_lua, -2, "__gc" );
+    lua_pop( m_lua, 1 );
+
+    /// The global table forwards to the methods ('Global.method( obj )') and constructs on call.
+    lua_rawgeti( m_lua, LUA_REGISTRYINDEX, m_global );
+    lua_createtable( m_lua, 0, 2 );
+    lua_rawgeti( m_lua, LUA_REGISTRYINDEX, m_methods );
+    lua_setfield( m_lua, -2, "__index" );
+    if( m_call != LUA_NOREF ) {
+        lua_rawgeti( m_lua, LUA_REGISTRYINDEX, m_call );
+        lua_setfield( m_lua, -2, "__call" );
+    }
+    lua_setmetatable( m_lua, -2 );
+    lua_setglobal( m_lua, m_global_name.c_str() );
+
+    return EASY_LUA_CAST_EASY( m_lua );
+}
+
+template<typename T>
+const easy_lua* easy_lua_class_binder<T>::push(
+    const easy_lua*         lua,
+    const std::string_view& metatable_name,
+    T*                      object )
+{
+    if( !object || metatable_name.empty() ) {
+        return nullptr;
+    }
+    const auto l = EASY_LUA_CAST_LUA( lua );
+    *static_cast<T**>( lua_newuserdata( l, sizeof( T* ) ) ) = object;
+    const std::string name( metatable_name );
+    luaL_getmetatable( l, name.c_str() );
+    lua_setmetatable( l, -2 );
+    return lua;
+}
+
+template<typename T>
+const easy_lua* easy_lua_class_binder<T>::push(
+    const easy_lua*                 lua,
+    const easy_lua::MetaTableArray& metatable,
+    T*                              object )
+{
+    return lua->push_userdata( metatable, object );
+}
+
+template<typename T>
+T* easy_lua_class_binder<T>::self(
+    lua_State*    l,
+    const int32_t stackpos,
+    const int32_t metatable )
+{
+    const auto block = static_cast<T**>( lua_touserdata( l, stackpos ) );
+    if( block && lua_getmetatable( l, stackpos ) ) {
+        const auto matches = lua_rawequal( l, -1, metatable ) != 0;
+        lua_pop( l, 1 );
+        if( matches && *block ) {
+            return *block;
+        }
+    }
+    lua_getfield( l, metatable, "__name" );
+    const auto name = lua_tostring( l, -1 );
+    luaL_typerror( l, stackpos, name ? name : "userdata" );
+    return nullptr;
+}
+
+template<typename T>
+template<auto Method>
+int easy_lua_class_binder<T>::method_closure(
+    lua_State* l )
+{
+    using callable = easy_lua_callable<decltype( Method )>;
+    using invoker  = typename invoker_of<typename callable::result, typename callable::arguments>::type;
+
+    const auto object   = self( l, 1, lua_upvalueindex( 1 ) );
+    auto       callback = [ object ]( auto&&... args ) -> decltype( auto )
+    {
+        return ( object->*Method )( std::forward<decltype( args )>( args )... );
+    };
+    return invoker::invoke( l, callback, 2 );
+}
+
+template<typename T>
+template<int32_t First, typename... Args>
+int easy_lua_class_binder<T>::constructor_closure(
+    lua_State* l )
+{
+    auto callback = [ l ]( Args... args )
+    {
+        const auto lua = EASY_LUA_CAST_EASY( l );
+        lua->new_userdata_value<T>( std::move( args )... );
+        lua_pushvalue( l, lua_upvalueindex( 1 ) );
+        lua_setmetatable( l, -2 );
+    };
+    easy_lua_invoker<void, Args...>::invoke( l, callback, First );
+    return 1;
+}
+
+template<typename T>
+template<auto Member>
+int32_t easy_lua_class_binder<T>::member_get(
+    lua_State* l,
+    T*         object )
+{
+    using member = std::decay_t<typename member_of<decltype( Member )>::type>;
+    return easy_lua_stack<member>::push( l, object->*Member );
+}
+
+template<typename T>
+template<auto Member>
+void easy_lua_class_binder<T>::member_set(
+    lua_State*    l,
+    T*            object,
+    const int32_t stackpos )
+{
+    using member = std::decay_t<typename member_of<decltype( Member )>::type>;
+    if constexpr( !std::is_const_v<typename member_of<decltype( Member )>::type> ) {
+        if( !easy_lua_stack<member>::check( l, stackpos ) ) {
+            luaL_typerror( l, stackpos, easy_lua_stack<member>::name );
+        }
+        object->*Member = easy_lua_stack<member>::get( l, stackpos );
+    }
+}
+
+template<typename T>
+template<auto Getter>
+int32_t easy_lua_class_binder<T>::getter_get(
+    lua_State* l,
+    T*         object )
+{
+    using result = std::decay_t<typename easy_lua_callable<decltype( Getter )>::result>;
+    return easy_lua_stack<result>::push( l, ( object->*Getter )() );
+}
+
+template<typename T>
+template<auto Setter>
+void easy_lua_class_binder<T>::setter_set(
+    lua_State*    l,
+    T*            object,
+    const int32_t stackpos )
+{
+    using value = std::decay_t<std::tuple_element_t<0, typename easy_lua_callable<decltype( Setter )>::arguments>>;
+    if( !easy_lua_stack<value>::check( l, stackpos ) ) {
+        luaL_typerror( l, stackpos, easy_lua_stack<value>::name );
+    }
+    ( object->*Setter )( easy_lua_stack<value>::get( l, stackpos ) );
+}
+
+template<typename T>
+int easy_lua_class_binder<T>::index(
+    lua_State* l )
+{
+    /// upvalues: 1 = metatable, 2 = methods, 3 = properties
+    const auto object = self( l, 1, lua_upvalueindex( 1 ) );
+    lua_pushvalue( l, 2 );
+    lua_rawget( l, lua_upvalueindex( 2 ) );
+    if( !lua_isnil( l, -1 ) ) {
+        return 1;
+    }
+    lua_pop( l, 1 );
+
+    lua_pushvalue( l, 2 );
+    lua_rawget( l, lua_upvalueindex( 3 ) );
+    const auto accessor = static_cast<const Accessor*>( lua_touserdata( l, -1 ) );
+    lua_pop( l, 1 );
+    if( accessor && accessor->get ) {
+        return accessor->get( l, object );
+    }
+    lua_pushnil( l );
+    return 1;
+}
+
+template<typename T>
+int easy_lua_class_binder<T>::new_index(
+    lua_State* l )
+{
+    const auto object = self( l, 1, lua_upvalueindex( 1 ) );
+    lua_pushvalue( l, 2 );
+    lua_rawget( l, lua_upvalueindex( 3 ) );
+    const auto accessor = static_cast<const Accessor*>( lua_touserdata( l, -1 ) );
+    lua_pop( l, 1 );
+    if( !accessor || !accessor->set ) {
+        return luaL_error( l, "cannot assign property '%s'", lua_tostring( l, 2 ) );
+    }
+    accessor->set( l, object, 3 );
+    return 0;
+}
+
+template<typename T>
+int easy_lua_class_binder<T>::gc(
+    lua_State* l )
+{
+    const auto lua = EASY_LUA_CAST_EASY( l );
+    return lua->destroy_userdata_value<T>( 1 );
+}
+
+template<typename T>
+void easy_lua_class_binder<T>::add_method(
+    const std::string_view& name,
+    const lua_CFunction     function ) const
+{
+    lua_rawgeti( m_lua, LUA_REGISTRYINDEX, m_methods );
+    lua_pushlstring( m_lua, name.data(), name.size() );
+    lua_rawgeti( m_lua, LUA_REGISTRYINDEX, m_metatable );
+    lua_pushcclosure( m_lua, function, 1 );
+    const auto lua = EASY_LUA_CAST_EASY( m_lua );
+    lua->instrument_function( m_global_name + "." + std::string( name ) );
+    lua_rawset( m_lua, -3 );
+    lua_pop( m_lua, 1 );
+}
+
+template<typename T>
+void easy_lua_class_binder<T>::add_property(
+    const std::string_view& name,
+    const Accessor*         accessor ) const
+{
+    lua_rawgeti( m_lua, LUA_REGISTRYINDEX, m_properties );
+    lua_pushlstring( m_lua, name.data(), name.size() );
+    lua_pushlightuserdata( m_lua, const_cast<Accessor*>( accessor ) );
+    lua_rawset( m_lua, -3 );
+    lua_pop( m_lua, 1 );
+}
@@ -0,0 +1,249 @@
+#include "easy_lua_executor.hpp"
+#include <algorithm>
+
+namespace {
+    /// The executor and worker index of the calling thread, used to keep nested jobs local.
+    thread_local const easy_lua_executor* current_executor = nullptr;
+    thread_local size_t                   current_worker   = 0;
+
+    easy_lua::Config include_config(
+        const std::string&         include_directory,
+        const easy_lua::EAllocator allocator )
+    {
+        easy_lua::Config config;
+        config.allocator = allocator;
+        if( !include_directory.empty() ) {
+            config.include_directories.push_back( include_directory );
+        }
+        return config;
+    }
+}
+
+easy_lua_executor::easy_lua_executor(
+    const size_t               workers,
+    const std::string&         include_directory,
+    FnSetup                    setup,
+    const easy_lua::EAllocator allocator )
+    : easy_lua_executor( workers, include_config( include_directory, allocator ), std::move( setup ) )
+{
+}
+
+easy_lua_executor::easy_lua_executor(
+    size_t                  workers,
+    const easy_lua::Config& config,
+    FnSetup                 setup )
+{
+    if( workers == 0 ) {
+        workers = std::max<size_t>( 1, std::thread::hardware_concurrency() );
+    }
+
+    std::vector<std::promise<bool>> ready( workers );
+    m_workers.reserve( workers );
+    for( size_t i = 0; i < workers; ++i ) {
+        m_workers.emplace_back( std::make_unique<Worker>() );
+    }
+    for( size_t i = 0; i < workers; ++i ) {
+        m_workers[ i ]->thread = std::thread( [ this, i, &config, &setup, &ready ]()
+        {
+            run( i, config, setup, ready[ i ] );
+        } );
+    }
+
+    m_running = true;
+    for( auto& promise : ready ) {
+        if( !promise.get_future().get() ) {
+            m_running = false;
+        }
+    }
+    if( !m_running ) {
+        stop();
+    }
+}
+
+easy_lua_executor::~easy_lua_executor()
+{
+    stop();
+    for( const auto& worker : m_workers ) {
+        if( worker->thread.joinable() ) {
+            worker->thread.join();
+        }
+    }
+}
+
+easy_lua_executor::operator bool() const
+{
+    return m_running;
+}
+
+size_t easy_lua_executor::size() const
+{
+    return m_workers.size();
+}
+
+bool easy_lua_executor::post(
+    FnJob job )
+{
+    if( !m_running || m_stop || !job ) {
+        return false;
+    }
+
+    const auto index = current_executor == this
+        ? current_worker
+        : m_next.fetch_add( 1, std::memory_order_relaxed ) % m_workers.size();
+    {
+        /// Counted before the job is visible, a worker taking it right away can not decrement
+        /// below zero. Under the sleep mutex, a worker can not miss it between check and wait.
+        std::lock_guard<std::mutex> lock( m_sleep_mutex );
+        ++m_pending;
+    }
+    {
+        auto& worker = *m_workers[ index ];
+        std::lock_guard<std::mutex> lock( worker.mutex );
+        worker.jobs.push_back( std::move( job ) );
+    }
+    notify( false );
+    return true;
+}
+
+bool easy_lua_executor::broadcast(
+    const FnJob& job )
+{
+    if( !m_running || m_stop || !job ) {
+        return false;
+    }
+
+    for( const auto& worker : m_workers ) {
+        {
+            std::lock_guard<std::mutex> lock( worker->mutex );
+            worker->pinned.push_back( job );
+        }
+        std::lock_guard<std::mutex> lock( m_sleep_mutex );
+        ++worker->pinned_count;
+    }
+    notify( true );
+    return true;
+}
+
+std::future<easy_lua_result<>> easy_lua_executor::execute(
+    std::string script,
+    const bool  from_memory )
+{
+    return submit( [ script = std::move( script ), from_memory ]( easy_lua* lua )
+    {
+        easy_lua_result<> result;
+        const auto        top = lua->top();
+        result.state = from_memory
+            ? lua->load_buffer( script, "=easy_lua" )
+            : lua->load_file( script );
+        if( result.state == easy_lua::State_Success ) {
+            result.state = lua->pcall( 0, 0, 0 );
+        }
+        if( result.state != easy_lua::State_Success ) {
+            result.error.assign( lua->get_string_view( -1 ) );
+        }
+        lua_settop( EASY_LUA_CAST_LUA( lua ), top );
+        return result;
+    } );
+}
+
+void easy_lua_executor::run(
+    const size_t            index,
+    const easy_lua::Config& config,
+    const FnSetup&          setup,
+    std::promise<bool>&     ready )
+{
+    auto lua = easy_lua::initialize( config );
+    if( lua && setup && !setup( lua ) ) {
+        easy_lua::close( &lua );
+    }
+    if( lua ) {
+        lua->pop_top();
+    }
+    /// 'ready' and the constructor arguments are gone after this.
+    ready.set_value( lua != nullptr );
+
+    current_executor = this;
+    current_worker   = index;
+    easy_lua::make_current( lua );
+    auto& self       = *m_workers[ index ];
+    for( ;; ) {
+        FnJob job;
+        if( self.pinned_count > 0 ) {
+            std::lock_guard<std::mutex> lock( self.mutex );
+            job = std::move( self.pinned.front() );
+            self.pinned.pop_front();
+            --self.pinned_count;
+        }
+        else if( !pop( index, job ) && !steal( index, job ) ) {
+            std::unique_lock<std::mutex> lock( m_sleep_mutex );
+            if( m_stop && m_pending == 0 ) {
+                break;
+            }
+            m_sleep.wait( lock, [ this, &self ]()
+            {
+                return m_stop || m_pending > 0 || self.pinned_count > 0;
+            } );
+            continue;
+        }
+
+        if( lua ) {
+            job( lua );
+        }
+    }
+
+    current_executor = nullptr;
+    easy_lua::close( &lua );
+}
+
+bool easy_lua_executor::pop(
+    const size_t index,
+    FnJob&       job )
+{
+    auto& worker = *m_workers[ index ];
+    std::lock_guard<std::mutex> lock( worker.mutex );
+    if( worker.jobs.empty() ) {
+        return false;
+    }
+    job = std::move( worker.jobs.back() );
+    worker.jobs.pop_back();
+    --m_pending;
+    return true;
+}
+
+bool easy_lua_executor::steal(
+    const size_t index,
+    FnJob&       job )
+{
+    const auto count = m_workers.size();
+    for( size_t i = 1; i < count; ++i ) {
+        auto& victim = *m_workers[ ( index + i ) % count ];
+        std::lock_guard<std::mutex> lock( victim.mutex );
+        if( !victim.jobs.empty() ) {
+            job = std::move( victim.jobs.front() );
+            victim.jobs.pop_front();
+            --m_pending;
+            return true;
+        }
+    }
+    return false;
+}
+
+void easy_lua_executor::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_sleep_mutex );
+        m_stop = true;
+    }
+    notify( true );
+}
+
+void easy_lua_executor::notify(
+    const bool all )
+{
+    if( all ) {
+        m_sleep.notify_all();
+    }
+    else {
+        m_sleep.notify_one();
+    }
+}
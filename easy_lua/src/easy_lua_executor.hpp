@@ -0,0 +1,252 @@
+///-------------------------------------------------------------------------------------------------
+/// Author:             ReactiioN
+/// Created:            16.10.2026
+///
+/// Last modified by:   ReactiioN
+/// Last modified on:   16.10.2026
+///-------------------------------------------------------------------------------------------------
+///     Copyright (c) ReactiioN <https://reactiion.pw>. All rights reserved.
+///-------------------------------------------------------------------------------------------------
+/// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+/// Copyright (c) 2016-2017 ReactiioN <https://reactiion.pw>.
+///-------------------------------------------------------------------------------------------------
+#pragma once
+#include "easy_lua.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <tuple>
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// Runs lua jobs in parallel. Every worker thread owns one state, created and set up on that
+/// thread, so all states start out identical. Jobs are queued on the worker deques: a worker
+/// takes its own jobs newest first and steals the oldest job of another worker once its deque
+/// ran dry. Jobs submitted from inside a job stay on the current worker.
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+class easy_lua_executor
+{
+public:
+    /// <summary>
+    /// The setup callback typedef, runs once on every worker after its state was initialized.
+    /// </summary>
+    using FnSetup = std::function<bool( easy_lua* )>;
+    /// <summary>
+    /// The job typedef, receives the state of the worker running it.
+    /// </summary>
+    using FnJob = std::function<void( easy_lua* )>;
+
+public:
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Constructor. Starts 'workers' threads and blocks until every state is set up.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="workers">              The number of threads, 0 for one per hardware thread. </param>
+    /// <param name="include_directory">    Pathname of the include directory. </param>
+    /// <param name="setup">                (Optional) The setup callback. </param>
+    /// <param name="allocator">            (Optional) The allocator of every state. </param>
+    ///-------------------------------------------------------------------------------------------------
+    easy_lua_executor(
+        size_t               workers,
+        const std::string&   include_directory,
+        FnSetup              setup     = nullptr,
+        easy_lua::EAllocator allocator = easy_lua::Allocator_Default );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Constructor. Starts 'workers' threads with states from 'config' and blocks until every
+    /// state is set up.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="workers">  The number of threads, 0 for one per hardware thread. </param>
+    /// <param name="config">   The configuration of every worker state. </param>
+    /// <param name="setup">    (Optional) The setup callback. </param>
+    ///-------------------------------------------------------------------------------------------------
+    easy_lua_executor(
+        size_t                  workers,
+        const easy_lua::Config& config,
+        FnSetup                 setup = nullptr );
+
+    easy_lua_executor( const easy_lua_executor& ) = delete;
+    easy_lua_executor& operator = ( const easy_lua_executor& ) = delete;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Destructor. Runs the queued jobs, joins the workers and closes the states. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///-------------------------------------------------------------------------------------------------
+    ~easy_lua_executor();
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Query if every worker state was created and set up. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   True if jobs are accepted, false if not. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    explicit operator bool() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the number of workers. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   A size_t. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    size_t size() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Queues a job on any worker. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="job">  The job. </param>
+    ///
+    /// <returns>   True if it succeeds, false if the executor is not running. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    bool post(
+        FnJob job );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Queues a copy of 'job' on every worker, it is never stolen. Use it to keep the states
+    /// identical, e.g. to export a function or to run a script everywhere.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="job">  The job. </param>
+    ///
+    /// <returns>   True if it succeeds, false if the executor is not running. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    bool broadcast(
+        const FnJob& job );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Queues a callable taking an easy_lua* and returns a future of its result. The future is
+    /// broken if the executor is not running.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="F">    Generic callable type parameter. </typeparam>
+    /// <param name="callback"> The callable. </param>
+    ///
+    /// <returns>   The future. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<typename F>
+    auto submit(
+        F&& callback ) -> std::future<std::invoke_result_t<std::decay_t<F>&, easy_lua*>>;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Executes a script file or an in-memory script on any worker. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="script">       The script or the pathname. </param>
+    /// <param name="from_memory">  (Optional) True to execute 'script' as source. </param>
+    ///
+    /// <returns>   The future of the state and the error message. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    std::future<easy_lua_result<>> execute(
+        std::string script,
+        bool        from_memory = false );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Calls a global function on any worker, see easy_lua::call. The arguments are copied into
+    /// the job, the result is converted to R on the worker.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="R">        The result type. </typeparam>
+    /// <typeparam name="Args">     The argument types. </typeparam>
+    /// <param name="function"> The global name of the function. </param>
+    /// <param name="args">     The arguments. </param>
+    ///
+    /// <returns>   The future of the result. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<typename R = void, typename... Args>
+    std::future<easy_lua_result<R>> call(
+        std::string function,
+        Args&&...   args );
+
+private:
+    struct Worker
+    {
+        std::mutex          mutex;
+        std::deque<FnJob>   jobs;
+        std::deque<FnJob>   pinned;
+        std::atomic<size_t> pinned_count{ 0 };
+        std::thread         thread;
+    };
+
+    void run(
+        size_t                  index,
+        const easy_lua::Config& config,
+        const FnSetup&          setup,
+        std::promise<bool>&     ready );
+
+    void stop();
+
+    bool pop(
+        size_t index,
+        FnJob& job );
+
+    bool steal(
+        size_t index,
+        FnJob& job );
+
+    void notify(
+        bool all );
+
+private:
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::mutex                           m_sleep_mutex;
+    std::condition_variable              m_sleep;
+    std::atomic<size_t>                  m_pending{ 0 };
+    std::atomic<size_t>                  m_next{ 0 };
+    std::atomic<bool>                    m_stop{ false };
+    bool                                 m_running = false;
+};
+
+template<typename F>
+auto easy_lua_executor::submit(
+    F&& callback ) -> std::future<std::invoke_result_t<std::decay_t<F>&, easy_lua*>>
+{
+    using R = std::invoke_result_t<std::decay_t<F>&, easy_lua*>;
+    /// FnJob has to be copyable, packaged_task is not.
+    auto task   = std::make_shared<std::packaged_task<R( easy_lua* )>>( std::forward<F>( callback ) );
+    auto future = task->get_future();
+    post( [ task ]( easy_lua* lua )
+    {
+        ( *task )( lua );
+    } );
+    return future;
+}
+
+template<typename R, typename... Args>
+std::future<easy_lua_result<R>> easy_lua_executor::call(
+    std::string function,
+    Args&&...   args )
+{
+    return submit( [ function = std::move( function ), arguments = std::make_tuple( std::forward<Args>( args )... ) ]( easy_lua* lua )
+    {
+        return std::apply( [ lua, &function ]( const auto&... values )
+        {
+            return lua->call<R>( function, values... );
+        }, arguments );
+    } );
+}
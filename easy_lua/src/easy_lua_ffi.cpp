@@ -0,0 +1,96 @@
+#include "easy_lua_ffi.hpp"
+
+namespace {
+    /// The address of this variable is the registry key of the ffi helpers of a state.
+    char helpers_key = 0;
+
+    /// Evaluates to false without the ffi module, the declared table is per state.
+    constexpr char helpers_source[] =
+        "local ok, ffi = pcall( require, 'ffi' )\n"
+        "if not ok then return false end\n"
+        "local declared = {}\n"
+        "return {\n"
+        "    cdef = function( name, source, size )\n"
+        "        if not declared[ name ] then\n"
+        "            ffi.cdef( source )\n"
+        "            declared[ name ] = true\n"
+        "        end\n"
+        "        return ffi.sizeof( name ) == size\n"
+        "    end,\n"
+        "    cast = ffi.cast,\n"
+        "}\n";
+
+    /// Pushes the helper 'name', nothing if the ffi module is not available.
+    bool push_helper(
+        lua_State*  l,
+        const char* name )
+    {
+        lua_pushlightuserdata( l, &helpers_key );
+        lua_rawget( l, LUA_REGISTRYINDEX );
+        if( lua_isnil( l, -1 ) ) {
+            lua_pop( l, 1 );
+            if( luaL_loadbuffer( l, helpers_source, sizeof( helpers_source ) - 1, "=easy_lua_ffi" ) != 0
+             || lua_pcall( l, 0, 1, 0 ) != 0 ) {
+                lua_pop( l, 1 );
+                lua_pushboolean( l, 0 );
+            }
+            lua_pushlightuserdata( l, &helpers_key );
+            lua_pushvalue( l, -2 );
+            lua_rawset( l, LUA_REGISTRYINDEX );
+        }
+        if( !lua_istable( l, -1 ) ) {
+            lua_pop( l, 1 );
+            return false;
+        }
+        lua_getfield( l, -1, name );
+        lua_remove( l, -2 );
+        return true;
+    }
+}
+
+bool easy_lua_ffi::available(
+    const easy_lua* lua )
+{
+    const auto l = EASY_LUA_CAST_LUA( lua );
+    if( !push_helper( l, "cast" ) ) {
+        return false;
+    }
+    lua_pop( l, 1 );
+    return true;
+}
+
+bool easy_lua_ffi::cdef(
+    const easy_lua*    lua,
+    const std::string& name,
+    const std::string& declaration,
+    const size_t       size )
+{
+    const auto l = EASY_LUA_CAST_LUA( lua );
+    if( !push_helper( l, "cdef" ) ) {
+        return false;
+    }
+    lua_pushlstring( l, name.data(), name.size() );
+    lua_pushlstring( l, declaration.data(), declaration.size() );
+    lua_pushnumber( l, static_cast<lua_Number>( size ) );
+    const auto matches = lua_pcall( l, 3, 1, 0 ) == 0 && lua_toboolean( l, -1 ) != 0;
+    lua_pop( l, 1 );
+    return matches;
+}
+
+const easy_lua* easy_lua_ffi::push_cast(
+    const easy_lua*    lua,
+    const std::string& ctype,
+    void*              address )
+{
+    const auto l = EASY_LUA_CAST_LUA( lua );
+    if( !push_helper( l, "cast" ) ) {
+        return nullptr;
+    }
+    lua_pushlstring( l, ctype.data(), ctype.size() );
+    lua_pushlightuserdata( l, address );
+    if( lua_pcall( l, 2, 1, 0 ) != 0 ) {
+        lua_pop( l, 1 );
+        return nullptr;
+    }
+    return lua;
+}
@@ -0,0 +1,491 @@
+///-------------------------------------------------------------------------------------------------
+/// Author:             ReactiioN
+/// Created:            16.10.2026
+///
+/// Last modified by:   ReactiioN
+/// Last modified on:   16.10.2026
+///-------------------------------------------------------------------------------------------------
+///     Copyright (c) ReactiioN <https://reactiion.pw>. All rights reserved.
+///-------------------------------------------------------------------------------------------------
+/// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+/// Copyright (c) 2016-2017 ReactiioN <https://reactiion.pw>.
+///-------------------------------------------------------------------------------------------------
+#pragma once
+#include "easy_lua.hpp"
+#include <algorithm>
+#include <cstddef>
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// Names the C type of T in generated ffi declarations. Arithmetic types map to the fixed width
+/// names, enums to their underlying type, pointers keep their constness and reflected structs
+/// are declared as 'struct name'. Other types have no C name and can not cross the FFI.
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+template<typename T, typename = void>
+struct easy_lua_ffi_type;
+
+template<>
+struct easy_lua_ffi_type<void>
+{
+    static std::string name()
+    {
+        return "void";
+    }
+};
+
+template<>
+struct easy_lua_ffi_type<bool>
+{
+    static std::string name()
+    {
+        return "bool";
+    }
+};
+
+template<>
+struct easy_lua_ffi_type<char>
+{
+    static std::string name()
+    {
+        return "char";
+    }
+};
+
+template<typename T>
+struct easy_lua_ffi_type<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char>>>
+{
+    static std::string name()
+    {
+        return std::string( std::is_signed_v<T> ? "int" : "uint" ) + std::to_string( sizeof( T ) * 8 ) + "_t";
+    }
+};
+
+template<>
+struct easy_lua_ffi_type<float>
+{
+    static std::string name()
+    {
+        return "float";
+    }
+};
+
+template<>
+struct easy_lua_ffi_type<double>
+{
+    static std::string name()
+    {
+        return "double";
+    }
+};
+
+template<typename T>
+struct easy_lua_ffi_type<T, std::enable_if_t<std::is_enum_v<T>>>
+    : easy_lua_ffi_type<std::underlying_type_t<T>>
+{
+};
+
+template<typename T>
+struct easy_lua_ffi_type<T*, std::void_t<decltype( easy_lua_ffi_type<std::remove_const_t<T>>::name() )>>
+{
+    static std::string name()
+    {
+        return ( std::is_const_v<T> ? "const " : "" ) + easy_lua_ffi_type<std::remove_const_t<T>>::name() + "*";
+    }
+};
+
+template<typename T>
+struct easy_lua_ffi_type<T, std::enable_if_t<easy_lua_is_reflected<T>::value>>
+{
+    static std::string name()
+    {
+        /// The reflected name may be qualified, C only knows plain identifiers.
+        std::string tag = easy_lua_reflect<T>::name;
+        std::replace_if( tag.begin(), tag.end(), []( const char c )
+        {
+            return !( ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || ( c >= '0' && c <= '9' ) );
+        }, '_' );
+        return "struct " + tag;
+    }
+};
+
+template<typename T, typename = void>
+struct easy_lua_has_ffi_type
+    : std::false_type
+{
+};
+
+template<typename T>
+struct easy_lua_has_ffi_type<T, std::void_t<decltype( easy_lua_ffi_type<T>::name() )>>
+    : std::true_type
+{
+};
+
+template<typename T, typename = void>
+struct easy_lua_has_stack
+    : std::false_type
+{
+};
+
+template<typename T>
+struct easy_lua_has_stack<T, std::void_t<decltype( sizeof( easy_lua_stack<T> ) )>>
+    : std::true_type
+{
+};
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// An optional binding mode for LuaJIT. Plain C++ functions are exposed as FFI function pointers
+/// and reflected POD structs as ffi.cdef declarations, both generated from the C++ types:
+///
+///     EASY_LUA_REFLECT( vec2, EASY_LUA_REFLECT_FIELD( vec2, x ), EASY_LUA_REFLECT_FIELD( vec2, y ) );
+///     double length( vec2 v );
+///
+///     easy_lua_ffi::export_function<&length>( lua, "length" );
+///
+/// Calls through the FFI are compiled into the traces of the calling loop, a lua_CFunction
+/// aborts them. The same function can be exported with Binding_Classic where the FFI is not
+/// wanted, Binding_FFI falls back to it when the ffi module is missing and every argument has
+/// an easy_lua_stack conversion. Differences in the FFI mode: structs are returned as cdata,
+/// tables are accepted as struct arguments, const char* results are cdata (ffi.string) and
+/// errors are not caught, the function has to validate its arguments itself.
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+class easy_lua_ffi
+{
+public:
+    enum EBinding : int32_t
+    {
+        /// <summary>
+        /// A lua_CFunction generated by easy_lua::export_function.
+        /// </summary>
+        Binding_Classic = 0,
+        /// <summary>
+        /// A cdata function pointer, see the class summary.
+        /// </summary>
+        Binding_FFI
+    };
+
+public:
+    easy_lua_ffi() = delete;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Query if the ffi module can be loaded by the state. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">  The lua. </param>
+    ///
+    /// <returns>   True if it is, false if not. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    static bool available(
+        const easy_lua* lua );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Runs ffi.cdef( declaration ) unless 'name' was declared before and verifies that the
+    /// declared type has 'size' bytes.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">          The lua. </param>
+    /// <param name="name">         The C type name. </param>
+    /// <param name="declaration">  The declaration. </param>
+    /// <param name="size">         The expected size in bytes. </param>
+    ///
+    /// <returns>   True if it succeeds, false if it fails. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    static bool cdef(
+        const easy_lua*    lua,
+        const std::string& name,
+        const std::string& declaration,
+        size_t             size );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Pushes ffi.cast( ctype, address ). </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">      The lua. </param>
+    /// <param name="ctype">    The C type. </param>
+    /// <param name="address">  The address. </param>
+    ///
+    /// <returns>   Null if it fails, else a pointer to a const easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    static const easy_lua* push_cast(
+        const easy_lua*    lua,
+        const std::string& ctype,
+        void*              address );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Generates the declaration of a reflected struct. Fields are ordered by their offset and
+    /// the gaps the reflection does not describe are declared as padding, so the layout matches
+    /// even if only some fields are reflected.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="T">    The reflected struct. </typeparam>
+    ///
+    /// <returns>   The declaration. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<typename T>
+    static std::string declaration();
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Declares a reflected struct and the structs it contains by value. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="T">    The reflected struct. </typeparam>
+    /// <param name="lua">  The lua. </param>
+    ///
+    /// <returns>   True if it succeeds, false if it fails. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<typename T>
+    static bool declare(
+        const easy_lua* lua );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Generates the C function pointer type of F, e.g. 'double(*)(struct vec2)'. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="F">    The function. </typeparam>
+    ///
+    /// <returns>   The C type. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<auto F>
+    static std::string signature();
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Pushes the function F bound with the given mode. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="F">    The function. </typeparam>
+    /// <param name="lua">      The lua. </param>
+    /// <param name="binding">  (Optional) The binding. </param>
+    ///
+    /// <returns>   Null if it fails, else a pointer to a const easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<auto F>
+    static const easy_lua* push_function(
+        const easy_lua* lua,
+        EBinding        binding = Binding_FFI );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Exports the function F bound with the given mode. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="F">    The function. </typeparam>
+    /// <param name="lua">      The lua. </param>
+    /// <param name="name">     The global name. </param>
+    /// <param name="binding">  (Optional) The binding. </param>
+    ///
+    /// <returns>   Null if it fails, else a pointer to a const easy_lua. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<auto F>
+    static const easy_lua* export_function(
+        const easy_lua*         lua,
+        const std::string_view& name,
+        EBinding                binding = Binding_FFI );
+
+private:
+    struct Field
+    {
+        size_t      offset;
+        size_t      size;
+        std::string declaration;
+    };
+
+    /// Declares a field 'name' of type M, arrays put their extent behind the name.
+    template<typename M>
+    struct Declarator
+    {
+        static std::string declare(
+            const std::string& name )
+        {
+            static_assert( easy_lua_has_ffi_type<M>::value, "The field type has no C name" );
+            return easy_lua_ffi_type<M>::name() + " " + name;
+        }
+    };
+
+    template<typename M, size_t N>
+    struct Declarator<M[ N ]>
+    {
+        static std::string declare(
+            const std::string& name )
+        {
+            return Declarator<M>::declare( name + "[" + std::to_string( N ) + "]" );
+        }
+    };
+
+    template<typename M, size_t N>
+    struct Declarator<std::array<M, N>>
+        : Declarator<M[ N ]>
+    {
+    };
+
+    template<typename R, typename Arguments>
+    struct Signature;
+
+    template<typename R, typename... Args>
+    struct Signature<R, std::tuple<Args...>>
+    {
+        static constexpr bool ffi     = ( easy_lua_has_ffi_type<R>::value && ... && easy_lua_has_ffi_type<Args>::value );
+        static constexpr bool classic = ( true && ... && easy_lua_has_stack<std::decay_t<Args>>::value );
+
+        static std::string name()
+        {
+            std::string result = easy_lua_ffi_type<R>::name() + "(*)(";
+            ( ( result += easy_lua_ffi_type<Args>::name() + "," ), ... );
+            if( result.back() == ',' ) {
+                result.back() = ')';
+            }
+            else {
+                result += "void)";
+            }
+            return result;
+        }
+
+        static bool declare(
+            const easy_lua* lua )
+        {
+            /// Unlike struct fields, pointer arguments declare their pointee so scripts can use it.
+            return ( declare_value<std::remove_cv_t<std::remove_pointer_t<R>>>( lua ) && ...
+                  && declare_value<std::remove_cv_t<std::remove_pointer_t<Args>>>( lua ) );
+        }
+    };
+
+    template<typename T>
+    static bool declare_value(
+        const easy_lua* lua );
+
+    template<typename T, typename M>
+    static size_t offset_of(
+        M T::* member );
+};
+
+template<typename T, typename M>
+size_t easy_lua_ffi::offset_of(
+    M T::* member )
+{
+    /// offsetof does not take member pointers, measure on uninitialized storage instead.
+    alignas( T ) static unsigned char storage[ sizeof( T ) ];
+    const auto object = reinterpret_cast<const T*>( storage );
+    return static_cast<size_t>( reinterpret_cast<const unsigned char*>( &( object->*member ) ) - storage );
+}
+
+template<typename T>
+std::string easy_lua_ffi::declaration()
+{
+    static_assert( easy_lua_is_reflected<T>::value, "Type T has to be reflected" );
+    static_assert( std::is_standard_layout_v<T> && std::is_trivially_copyable_v<T>, "Type T has to be a POD struct" );
+
+    std::vector<Field> fields;
+    std::apply( [ &fields ]( const auto&... reflected )
+    {
+        ( fields.push_back( Field{
+            offset_of( reflected.member ),
+            sizeof( std::declval<T&>().*reflected.member ),
+            Declarator<std::remove_reference_t<decltype( std::declval<T&>().*reflected.member )>>::declare( reflected.name )
+        } ), ... );
+    }, easy_lua_reflect<T>::fields );
+    std::sort( fields.begin(), fields.end(), []( const Field& a, const Field& b )
+    {
+        return a.offset < b.offset;
+    } );
+
+    const auto  tag    = easy_lua_ffi_type<T>::name();
+    std::string result = tag + " { ";
+    size_t      offset = 0;
+    size_t      pads   = 0;
+    for( const auto& field : fields ) {
+        if( field.offset > offset ) {
+            result += "uint8_t pad" + std::to_string( pads++ ) + "[" + std::to_string( field.offset - offset ) + "]; ";
+        }
+        result += field.declaration + "; ";
+        offset  = field.offset + field.size;
+    }
+    if( sizeof( T ) > offset ) {
+        result += "uint8_t pad" + std::to_string( pads ) + "[" + std::to_string( sizeof( T ) - offset ) + "]; ";
+    }
+    /// 'struct name' is always usable, the typedef lets scripts write ffi.new( "name" ).
+    return result + "}; typedef " + tag + " " + tag.substr( 7 ) + ";";
+}
+
+template<typename T>
+bool easy_lua_ffi::declare_value(
+    const easy_lua* lua )
+{
+    if constexpr( std::is_array_v<T> ) {
+        return declare_value<std::remove_all_extents_t<T>>( lua );
+    }
+    else if constexpr( easy_lua_is_reflected<T>::value ) {
+        return declare<T>( lua );
+    }
+    else {
+        return true;
+    }
+}
+
+template<typename T>
+bool easy_lua_ffi::declare(
+    const easy_lua* lua )
+{
+    /// Structs contained by value have to be complete first, pointers only need the tag.
+    const auto members = std::apply( [ lua ]( const auto&... reflected )
+    {
+        return ( true && ... && declare_value<std::remove_reference_t<decltype( std::declval<T&>().*reflected.member )>>( lua ) );
+    }, easy_lua_reflect<T>::fields );
+    return members && cdef( lua, easy_lua_ffi_type<T>::name(), declaration<T>(), sizeof( T ) );
+}
+
+template<auto F>
+std::string easy_lua_ffi::signature()
+{
+    using callable = easy_lua_callable<decltype( F )>;
+    return Signature<typename callable::result, typename callable::arguments>::name();
+}
+
+template<auto F>
+const easy_lua* easy_lua_ffi::push_function(
+    const easy_lua* lua,
+    const EBinding  binding )
+{
+    static_assert( std::is_pointer_v<decltype( F )> && std::is_function_v<std::remove_pointer_t<decltype( F )>>,
+                   "F has to be a plain function" );
+    using callable  = easy_lua_callable<decltype( F )>;
+    using signature = Signature<typename callable::result, typename callable::arguments>;
+    static_assert( signature::ffi || signature::classic, "F can be bound by neither mode" );
+
+    if constexpr( signature::ffi ) {
+        if( binding == Binding_FFI
+         && signature::declare( lua )
+         && push_cast( lua, signature::name(), reinterpret_cast<void*>( F ) ) ) {
+            return lua;
+        }
+    }
+    if constexpr( signature::classic ) {
+        return lua->push_function( F );
+    }
+    else {
+        return nullptr;
+    }
+}
+
+template<auto F>
+const easy_lua* easy_lua_ffi::export_function(
+    const easy_lua*         lua,
+    const std::string_view& name,
+    const EBinding          binding )
+{
+    if( name.empty() || !push_function<F>( lua, binding ) ) {
+        return nullptr;
+    }
+    return lua->set_global( name );
+}
@@ -0,0 +1,230 @@
+///-------------------------------------------------------------------------------------------------
+/// Author:             ReactiioN
+/// Created:            16.10.2026
+///
+/// Last modified by:   ReactiioN
+/// Last modified on:   16.10.2026
+///-------------------------------------------------------------------------------------------------
+///     Copyright (c) ReactiioN <https://reactiion.pw>. All rights reserved.
+///-------------------------------------------------------------------------------------------------
+/// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+/// Copyright (c) 2016-2017 ReactiioN <https://reactiion.pw>.
+///-------------------------------------------------------------------------------------------------
+#pragma once
+#include "easy_lua.hpp"
+
+template<typename Signature>
+class easy_lua_function_ref;
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// A lua function pinned in the registry with luaL_ref. Calls skip the global lookup, the
+/// reference is released by the destructor and turns invalid once the state is closed.
+///     easy_lua_function_ref<double( double, double )> add( lua, "add" );
+///     const auto sum = add( 1.0, 2.0 );
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+template<typename R, typename... Args>
+class easy_lua_function_ref<R( Args... )>
+{
+public:
+    easy_lua_function_ref() = default;
+    easy_lua_function_ref( const easy_lua_function_ref& ) = delete;
+    easy_lua_function_ref& operator = ( const easy_lua_function_ref& ) = delete;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Pins the global function 'global'. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">      The lua. </param>
+    /// <param name="global">   The global name of the function. </param>
+    ///-------------------------------------------------------------------------------------------------
+    easy_lua_function_ref(
+        const easy_lua*         lua,
+        const std::string_view& global )
+    {
+        lua->get_global( global );
+        pin( lua );
+    }
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Pins the function at 'stackpos', the stack is not modified. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">      The lua. </param>
+    /// <param name="stackpos"> The stackpos of the function. </param>
+    ///-------------------------------------------------------------------------------------------------
+    easy_lua_function_ref(
+        const easy_lua* lua,
+        const int32_t   stackpos )
+    {
+        lua_pushvalue( EASY_LUA_CAST_LUA( lua ), stackpos );
+        pin( lua );
+    }
+
+    easy_lua_function_ref(
+        easy_lua_function_ref&& other ) noexcept
+        : m_lua( other.m_lua )
+        , m_reference( other.m_reference )
+        , m_lifetime( std::move( other.m_lifetime ) )
+        , m_tracked( other.m_tracked )
+    {
+        other.m_lua       = nullptr;
+        other.m_reference = LUA_NOREF;
+    }
+
+    easy_lua_function_ref& operator = (
+        easy_lua_function_ref&& other ) noexcept
+    {
+        if( this != &other ) {
+            release();
+            m_lua             = other.m_lua;
+            m_reference       = other.m_reference;
+            m_lifetime        = std::move( other.m_lifetime );
+            m_tracked         = other.m_tracked;
+            other.m_lua       = nullptr;
+            other.m_reference = LUA_NOREF;
+        }
+        return *this;
+    }
+
+    ~easy_lua_function_ref()
+    {
+        release();
+    }
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Unpins the function, the reference is invalid afterwards. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///-------------------------------------------------------------------------------------------------
+    void release()
+    {
+        if( valid() ) {
+            luaL_unref( EASY_LUA_CAST_LUA( m_lua ), LUA_REGISTRYINDEX, m_reference );
+        }
+        m_lua       = nullptr;
+        m_reference = LUA_NOREF;
+    }
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Query if a function is pinned and its state is still open. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   True if valid, false if not. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    bool valid() const
+    {
+        return m_lua && m_reference != LUA_NOREF && !( m_tracked && m_lifetime.expired() );
+    }
+
+    explicit operator bool() const
+    {
+        return valid();
+    }
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Pushes the function. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   True if it succeeds, false if the reference is invalid. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    bool push() const
+    {
+        if( !valid() ) {
+            return false;
+        }
+        lua_rawgeti( EASY_LUA_CAST_LUA( m_lua ), LUA_REGISTRYINDEX, m_reference );
+        return true;
+    }
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Calls the function, see easy_lua::call. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="args"> The arguments. </param>
+    ///
+    /// <returns>   The state, the error message on failure and the converted value. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    easy_lua_result<R> operator () (
+        const Args&... args ) const
+    {
+        easy_lua_result<R> result;
+        if( !push() ) {
+            result.state = easy_lua::State_Runtime;
+            result.error = "invalid function reference";
+            return result;
+        }
+        m_lua->call_at( -1, result, args... );
+        lua_pop( EASY_LUA_CAST_LUA( m_lua ), 1 );
+        return result;
+    }
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Calls the function once per input tuple, see easy_lua::call_batch. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="inputs">   The arguments of every call. </param>
+    /// <param name="count">    The number of calls. </param>
+    /// <param name="outputs">  [out] Preallocated space for 'count' results. </param>
+    ///
+    /// <returns>   The number of failed calls, 'count' if the reference is invalid. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    size_t batch(
+        const std::tuple<Args...>* inputs,
+        const size_t               count,
+        easy_lua_result<R>*        outputs ) const
+    {
+        if( !push() ) {
+            for( size_t i = 0; i < count; ++i ) {
+                outputs[ i ].state = easy_lua::State_Runtime;
+                outputs[ i ].error = "invalid function reference";
+            }
+            return count;
+        }
+
+        const auto function_index = m_lua->top();
+        size_t     failed         = 0;
+        for( size_t i = 0; i < count; ++i ) {
+            const auto state = std::apply( [ this, function_index, outputs, i ]( const Args&... args )
+            {
+                return m_lua->call_at( function_index, outputs[ i ], args... );
+            }, inputs[ i ] );
+            if( state != easy_lua::State_Success ) {
+                ++failed;
+            }
+        }
+        lua_pop( EASY_LUA_CAST_LUA( m_lua ), 1 );
+        return failed;
+    }
+
+private:
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Pops the top value and pins it if it is a function. </summary>
+    ///-------------------------------------------------------------------------------------------------
+    void pin(
+        const easy_lua* lua )
+    {
+        const auto l = EASY_LUA_CAST_LUA( lua );
+        if( !lua_isfunction( l, -1 ) ) {
+            lua_pop( l, 1 );
+            return;
+        }
+        m_lua       = const_cast<easy_lua*>( lua );
+        m_reference = luaL_ref( l, LUA_REGISTRYINDEX );
+        m_lifetime  = lua->lifetime();
+        m_tracked   = !m_lifetime.expired();
+    }
+
+private:
+    easy_lua*           m_lua       = nullptr;
+    int32_t             m_reference = LUA_NOREF;
+    std::weak_ptr<void> m_lifetime;
+    bool                m_tracked   = false;
+};
@@ -0,0 +1,305 @@
+#include "easy_lua_pool.hpp"
+
+namespace {
+    /// The address of this variable is the registry key of the globals baseline.
+    char baseline_key = 0;
+
+    int32_t absolute(
+        lua_State*    l,
+        const int32_t index )
+    {
+        return index > 0 || index <= LUA_REGISTRYINDEX ? index : lua_gettop( l ) + index + 1;
+    }
+
+    /// Pushes a shallow copy of the table at 'index'.
+    void push_copy(
+        lua_State* l,
+        int32_t    index )
+    {
+        index = absolute( l, index );
+        lua_newtable( l );
+        lua_pushnil( l );
+        while( lua_next( l, index ) != 0 ) {
+            lua_pushvalue( l, -2 );
+            lua_insert( l, -2 );
+            lua_rawset( l, -4 );
+        }
+    }
+
+    /// Records a copy of the table at -1 in the map at 'tables', the table is popped.
+    void record_table(
+        lua_State*    l,
+        const int32_t tables )
+    {
+        if( !lua_istable( l, -1 ) ) {
+            lua_pop( l, 1 );
+            return;
+        }
+        push_copy( l, -1 );
+        lua_rawset( l, tables );
+    }
+
+    /// Makes the fields of the table at 'target' equal to the copy at 'baseline'.
+    void restore_table(
+        lua_State* l,
+        int32_t    target,
+        int32_t    baseline )
+    {
+        target   = absolute( l, target );
+        baseline = absolute( l, baseline );
+
+        /// Existing fields may be overwritten or cleared while traversing, new ones may not be added.
+        lua_pushnil( l );
+        while( lua_next( l, target ) != 0 ) {
+            lua_pushvalue( l, -2 );
+            lua_rawget( l, baseline );
+            if( !lua_rawequal( l, -1, -2 ) ) {
+                lua_pushvalue( l, -3 );
+                lua_insert( l, -2 );
+                lua_rawset( l, target );
+                lua_pop( l, 1 );
+            }
+            else {
+                lua_pop( l, 2 );
+            }
+        }
+
+        lua_pushnil( l );
+        while( lua_next( l, baseline ) != 0 ) {
+            lua_pushvalue( l, -2 );
+            lua_rawget( l, target );
+            if( lua_isnil( l, -1 ) ) {
+                lua_pop( l, 1 );
+                lua_pushvalue( l, -2 );
+                lua_insert( l, -2 );
+                lua_rawset( l, target );
+            }
+            else {
+                lua_pop( l, 2 );
+            }
+        }
+    }
+
+    easy_lua::Config include_config(
+        const std::string& include_directory )
+    {
+        easy_lua::Config config;
+        if( !include_directory.empty() ) {
+            config.include_directories.push_back( include_directory );
+        }
+        return config;
+    }
+}
+
+easy_lua_pool::Handle::Handle(
+    easy_lua_pool* pool,
+    easy_lua*      lua )
+    : m_pool( pool )
+    , m_lua( lua )
+{
+}
+
+easy_lua_pool::Handle::Handle(
+    Handle&& other ) noexcept
+    : m_pool( other.m_pool )
+    , m_lua( other.m_lua )
+{
+    other.m_pool = nullptr;
+    other.m_lua  = nullptr;
+}
+
+easy_lua_pool::Handle& easy_lua_pool::Handle::operator = (
+    Handle&& other ) noexcept
+{
+    if( this != &other ) {
+        release();
+        m_pool       = other.m_pool;
+        m_lua        = other.m_lua;
+        other.m_pool = nullptr;
+        other.m_lua  = nullptr;
+    }
+    return *this;
+}
+
+easy_lua_pool::Handle::~Handle()
+{
+    release();
+}
+
+easy_lua* easy_lua_pool::Handle::get() const
+{
+    return m_lua;
+}
+
+void easy_lua_pool::Handle::release()
+{
+    if( m_pool && m_lua ) {
+        m_pool->release( m_lua );
+    }
+    m_pool = nullptr;
+    m_lua  = nullptr;
+}
+
+easy_lua* easy_lua_pool::Handle::operator -> () const
+{
+    return m_lua;
+}
+
+easy_lua_pool::Handle::operator bool() const
+{
+    return m_lua != nullptr;
+}
+
+easy_lua_pool::easy_lua_pool(
+    const size_t       capacity,
+    const std::string& include_directory,
+    FnSetup            setup )
+    : easy_lua_pool( capacity, include_config( include_directory ), std::move( setup ) )
+{
+}
+
+easy_lua_pool::easy_lua_pool(
+    const size_t            capacity,
+    const easy_lua::Config& config,
+    FnSetup                 setup )
+    : m_capacity( capacity )
+    , m_config( config )
+    , m_setup( std::move( setup ) )
+{
+    m_states.reserve( capacity );
+    for( size_t i = 0; i < capacity; ++i ) {
+        const auto lua = create();
+        if( !lua ) {
+            break;
+        }
+        m_states.push_back( lua );
+    }
+}
+
+easy_lua_pool::~easy_lua_pool()
+{
+    for( auto lua : m_states ) {
+        easy_lua::close( &lua );
+    }
+}
+
+easy_lua_pool::Handle easy_lua_pool::acquire()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        if( !m_states.empty() ) {
+            const auto lua = m_states.back();
+            m_states.pop_back();
+            return Handle( this, lua );
+        }
+    }
+    return Handle( this, create() );
+}
+
+size_t easy_lua_pool::available() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    return m_states.size();
+}
+
+void easy_lua_pool::snapshot_globals(
+    const easy_lua* lua )
+{
+    /// The baseline is { copy of _G, { [ table ] = copy of table } }.
+    const auto l   = EASY_LUA_CAST_LUA( lua );
+    const auto top = lua_gettop( l );
+    lua_pushlightuserdata( l, &baseline_key );
+    lua_createtable( l, 2, 0 );
+    push_copy( l, LUA_GLOBALSINDEX );
+    lua_rawseti( l, -2, 1 );
+
+    lua_newtable( l );
+    const auto tables = lua_gettop( l );
+    lua_pushnil( l );
+    while( lua_next( l, LUA_GLOBALSINDEX ) != 0 ) {
+        lua_pushvalue( l, LUA_GLOBALSINDEX );
+        const auto is_globals = lua_rawequal( l, -1, -2 ) != 0;
+        lua_pop( l, 1 );
+        if( is_globals ) {
+            lua_pop( l, 1 );
+        }
+        else {
+            lua_pushvalue( l, -1 );
+            record_table( l, tables );
+            lua_pop( l, 1 );
+        }
+    }
+    lua_getglobal( l, "package" );
+    if( lua_istable( l, -1 ) ) {
+        lua_getfield( l, -1, "loaded" );
+        record_table( l, tables );
+    }
+    lua_pop( l, 1 );
+    lua_pushliteral( l, "" );
+    if( lua_getmetatable( l, -1 ) ) {
+        record_table( l, tables );
+    }
+    lua_pop( l, 1 );
+    lua_rawseti( l, -2, 2 );
+
+    lua_rawset( l, LUA_REGISTRYINDEX );
+    lua_settop( l, top );
+}
+
+bool easy_lua_pool::restore_globals(
+    const easy_lua* lua )
+{
+    const auto l = EASY_LUA_CAST_LUA( lua );
+    lua_settop( l, 0 );
+    lua_pushlightuserdata( l, &baseline_key );
+    lua_rawget( l, LUA_REGISTRYINDEX );
+    if( !lua_istable( l, 1 ) ) {
+        lua_settop( l, 0 );
+        return false;
+    }
+
+    /// Globals first, a replaced library table has to be back before its fields are restored.
+    lua_rawgeti( l, 1, 1 );
+    restore_table( l, LUA_GLOBALSINDEX, 2 );
+    lua_rawgeti( l, 1, 2 );
+    lua_pushnil( l );
+    while( lua_next( l, 3 ) != 0 ) {
+        restore_table( l, -2, -1 );
+        lua_pop( l, 1 );
+    }
+
+    lua_settop( l, 0 );
+    return true;
+}
+
+easy_lua* easy_lua_pool::create() const
+{
+    auto lua = easy_lua::initialize( m_config );
+    if( !lua ) {
+        return nullptr;
+    }
+    if( m_setup && !m_setup( lua ) ) {
+        easy_lua::close( &lua );
+        return nullptr;
+    }
+    lua->pop_top();
+    snapshot_globals( lua );
+    return lua;
+}
+
+void easy_lua_pool::release(
+    easy_lua* lua )
+{
+    if( !lua ) {
+        return;
+    }
+    restore_globals( lua );
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        if( m_states.size() < m_capacity ) {
+            m_states.push_back( lua );
+            return;
+        }
+    }
+    easy_lua::close( &lua );
+}
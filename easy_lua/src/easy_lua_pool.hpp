@@ -0,0 +1,170 @@
+///-------------------------------------------------------------------------------------------------
+/// Author:             ReactiioN
+/// Created:            16.10.2026
+///
+/// Last modified by:   ReactiioN
+/// Last modified on:   16.10.2026
+///-------------------------------------------------------------------------------------------------
+///     Copyright (c) ReactiioN <https://reactiion.pw>. All rights reserved.
+///-------------------------------------------------------------------------------------------------
+/// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+/// Copyright (c) 2016-2017 ReactiioN <https://reactiion.pw>.
+///-------------------------------------------------------------------------------------------------
+#pragma once
+#include "easy_lua.hpp"
+#include <functional>
+#include <mutex>
+
+class easy_lua_pool
+{
+public:
+    /// <summary>
+    /// The setup callback typedef, runs once per state before the globals baseline is recorded.
+    /// </summary>
+    using FnSetup = std::function<bool( easy_lua* )>;
+
+    class Handle
+    {
+        friend class easy_lua_pool;
+
+    public:
+        Handle() = default;
+        Handle( const Handle& ) = delete;
+        Handle& operator = ( const Handle& ) = delete;
+
+        Handle(
+            Handle&& other ) noexcept;
+
+        Handle& operator = (
+            Handle&& other ) noexcept;
+
+        ~Handle();
+
+        ///-------------------------------------------------------------------------------------------------
+        /// <summary>   Gets the pooled state. </summary>
+        ///
+        /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+        ///
+        /// <returns>   Null if empty, else a pointer to an easy_lua. </returns>
+        ///-------------------------------------------------------------------------------------------------
+        easy_lua* get() const;
+
+        ///-------------------------------------------------------------------------------------------------
+        /// <summary>   Returns the state to its pool ahead of destruction. </summary>
+        ///
+        /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+        ///-------------------------------------------------------------------------------------------------
+        void release();
+
+        easy_lua* operator -> () const;
+
+        explicit operator bool() const;
+
+    private:
+        Handle(
+            easy_lua_pool* pool,
+            easy_lua*      lua );
+
+    private:
+        easy_lua_pool* m_pool = nullptr;
+        easy_lua*      m_lua  = nullptr;
+    };
+
+public:
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Constructor. Creates 'capacity' pre-warmed states. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="capacity">             The number of idle states kept alive. </param>
+    /// <param name="include_directory">    Pathname of the include directory. </param>
+    /// <param name="setup">                (Optional) The setup callback. </param>
+    ///-------------------------------------------------------------------------------------------------
+    easy_lua_pool(
+        size_t             capacity,
+        const std::string& include_directory,
+        FnSetup            setup = nullptr );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Constructor. Creates 'capacity' pre-warmed states from 'config'. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="capacity"> The number of idle states kept alive. </param>
+    /// <param name="config">   The configuration of every pooled state. </param>
+    /// <param name="setup">    (Optional) The setup callback. </param>
+    ///-------------------------------------------------------------------------------------------------
+    easy_lua_pool(
+        size_t                  capacity,
+        const easy_lua::Config& config,
+        FnSetup                 setup = nullptr );
+
+    easy_lua_pool( const easy_lua_pool& ) = delete;
+    easy_lua_pool& operator = ( const easy_lua_pool& ) = delete;
+
+    ~easy_lua_pool();
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Takes an idle state out of the pool. A new state is created if the pool is exhausted.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   An empty handle if a state could not be created, else the state handle. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    Handle acquire();
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the number of idle states. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   A size_t. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    size_t available() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Records the current globals as the baseline restored on release, together with the fields
+    /// of every table held by a global, package.loaded and the string metatable.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">  The lua. </param>
+    ///-------------------------------------------------------------------------------------------------
+    static void snapshot_globals(
+        const easy_lua* lua );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Restores the globals table to the recorded baseline. Globals added since the snapshot are
+    /// removed, overwritten or removed ones get their baseline value back. The same is done for
+    /// the fields of the recorded tables, so changes to string, table, package.loaded or a
+    /// table set up as global do not leak into the next request. Deeper tables, metatables
+    /// other than the string metatable and upvalues are not restored.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">  The lua. </param>
+    ///
+    /// <returns>   True if it succeeds, false if no baseline was recorded. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    static bool restore_globals(
+        const easy_lua* lua );
+
+private:
+    easy_lua* create() const;
+
+    void release(
+        easy_lua* lua );
+
+private:
+    mutable std::mutex     m_mutex;
+    size_t                 m_capacity;
+    easy_lua::Config       m_config;
+    FnSetup                m_setup;
+    std::vector<easy_lua*> m_states;
+};
@@ -0,0 +1,262 @@
+#include "easy_lua_profiler.hpp"
+#include <algorithm>
+
+namespace {
+    /// The address of this variable is the registry key of the profiler of a state.
+    char profiler_key = 0;
+
+    /// Bumped by every timer tick. The hook only looks its profiler up after a tick, so the
+    /// registry is not touched between samples. With several profiled states on one thread a
+    /// tick consumed by another state delays the sample to the next tick.
+    std::atomic<uint64_t> due_generation{ 0 };
+    thread_local uint64_t seen_generation = 0;
+
+    std::string frame_name(
+        const lua_Debug& frame )
+    {
+        if( *frame.what == 'C' ) {
+            return std::string( "[C] " ) + ( frame.name ? frame.name : "?" );
+        }
+        if( *frame.what == 'm' ) {
+            return "main chunk";
+        }
+        return frame.name ? frame.name : "anonymous";
+    }
+}
+
+easy_lua_profiler::easy_lua_profiler(
+    easy_lua* lua )
+    : easy_lua_profiler( lua, Options() )
+{
+}
+
+easy_lua_profiler::easy_lua_profiler(
+    easy_lua*      lua,
+    const Options& options )
+    : m_lua( lua )
+    , m_options( options )
+    , m_lifetime( lua->lifetime() )
+    , m_tracked( !m_lifetime.expired() )
+{
+    m_options.check_instructions = std::max( m_options.check_instructions, 1 );
+    m_options.max_depth          = std::max( m_options.max_depth, 1 );
+
+    const auto l = EASY_LUA_CAST_LUA( lua );
+    lua_pushlightuserdata( l, &profiler_key );
+    lua_pushlightuserdata( l, this );
+    lua_rawset( l, LUA_REGISTRYINDEX );
+}
+
+easy_lua_profiler::~easy_lua_profiler()
+{
+    stop();
+    if( m_tracked && m_lifetime.expired() ) {
+        return;
+    }
+
+    const auto l = EASY_LUA_CAST_LUA( m_lua );
+    lua_pushlightuserdata( l, &profiler_key );
+    lua_rawget( l, LUA_REGISTRYINDEX );
+    const auto registered = lua_touserdata( l, -1 ) == this;
+    lua_pop( l, 1 );
+    if( registered ) {
+        lua_pushlightuserdata( l, &profiler_key );
+        lua_pushnil( l );
+        lua_rawset( l, LUA_REGISTRYINDEX );
+    }
+}
+
+bool easy_lua_profiler::start()
+{
+    const auto l = EASY_LUA_CAST_LUA( m_lua );
+    if( m_running || ( m_tracked && m_lifetime.expired() ) || lua_gethook( l ) ) {
+        return false;
+    }
+
+    lua_sethook( l, &hook, LUA_MASKCOUNT, m_options.check_instructions );
+    m_stop_timer = false;
+    m_timer      = std::thread( [ this ]()
+    {
+        run_timer();
+    } );
+    m_running = true;
+    return true;
+}
+
+void easy_lua_profiler::stop()
+{
+    if( !m_running ) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock( m_timer_mutex );
+        m_stop_timer = true;
+    }
+    m_timer_cv.notify_one();
+    m_timer.join();
+    m_running = false;
+    m_due     = false;
+
+    if( !( m_tracked && m_lifetime.expired() ) ) {
+        const auto l = EASY_LUA_CAST_LUA( m_lua );
+        if( lua_gethook( l ) == &hook ) {
+            lua_sethook( l, nullptr, 0, 0 );
+        }
+    }
+}
+
+bool easy_lua_profiler::running() const
+{
+    return m_running;
+}
+
+void easy_lua_profiler::reset()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_samples = 0;
+    m_functions.clear();
+    m_lines.clear();
+    m_stacks.clear();
+}
+
+uint64_t easy_lua_profiler::samples() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    return m_samples;
+}
+
+easy_lua_profiler::Report easy_lua_profiler::report(
+    const size_t limit ) const
+{
+    Report report;
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        report.samples = m_samples;
+        report.functions.reserve( m_functions.size() );
+        for( const auto& [ key, entry ] : m_functions ) {
+            report.functions.push_back( entry.function );
+        }
+        report.lines.reserve( m_lines.size() );
+        for( const auto& [ key, line ] : m_lines ) {
+            report.lines.push_back( line );
+        }
+    }
+
+    std::sort( report.functions.begin(), report.functions.end(), []( const Function& a, const Function& b )
+    {
+        return a.self_samples != b.self_samples
+            ? a.self_samples > b.self_samples
+            : a.total_samples > b.total_samples;
+    } );
+    std::sort( report.lines.begin(), report.lines.end(), []( const Line& a, const Line& b )
+    {
+        return a.samples > b.samples;
+    } );
+    if( limit != 0 ) {
+        report.functions.resize( std::min( limit, report.functions.size() ) );
+        report.lines.resize( std::min( limit, report.lines.size() ) );
+    }
+    return report;
+}
+
+std::string easy_lua_profiler::folded() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    std::string result;
+    for( const auto& [ stack, count ] : m_stacks ) {
+        result.append( stack ).append( " " ).append( std::to_string( count ) ).append( "\n" );
+    }
+    return result;
+}
+
+void easy_lua_profiler::hook(
+    lua_State* l,
+    lua_Debug* )
+{
+    const auto generation = due_generation.load( std::memory_order_relaxed );
+    if( generation == seen_generation ) {
+        return;
+    }
+    seen_generation = generation;
+
+    lua_pushlightuserdata( l, &profiler_key );
+    lua_rawget( l, LUA_REGISTRYINDEX );
+    const auto profiler = static_cast<easy_lua_profiler*>( lua_touserdata( l, -1 ) );
+    lua_pop( l, 1 );
+    if( profiler && profiler->m_due.exchange( false, std::memory_order_relaxed ) ) {
+        profiler->sample( l );
+    }
+}
+
+void easy_lua_profiler::sample(
+    lua_State* l )
+{
+    /// Frames from the innermost outwards: label, name, chunk and line defined.
+    std::vector<std::pair<std::string, Function>> frames;
+    std::string                                   line_key;
+    Line                                          line;
+    lua_Debug                                     frame;
+    for( auto level = 0; level < m_options.max_depth && lua_getstack( l, level, &frame ); ++level ) {
+        if( !lua_getinfo( l, "Sln", &frame ) ) {
+            break;
+        }
+        Function function;
+        function.name  = frame_name( frame );
+        function.chunk = frame.short_src;
+        function.line  = frame.linedefined;
+
+        auto label = function.name + " " + function.chunk + ":" + std::to_string( function.line );
+        std::replace( label.begin(), label.end(), ';', ':' );
+        frames.emplace_back( std::move( label ), std::move( function ) );
+
+        if( line_key.empty() && frame.currentline > 0 ) {
+            line.chunk = frame.short_src;
+            line.line  = frame.currentline;
+            line_key   = line.chunk + ":" + std::to_string( line.line );
+        }
+    }
+    if( frames.empty() ) {
+        return;
+    }
+
+    std::string stack;
+    for( auto it = frames.rbegin(); it != frames.rend(); ++it ) {
+        if( !stack.empty() ) {
+            stack += ';';
+        }
+        stack += it->first;
+    }
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+    ++m_samples;
+    ++m_stacks[ stack ];
+    for( size_t i = 0; i < frames.size(); ++i ) {
+        auto& entry = m_functions[ frames[ i ].first ];
+        if( entry.function.name.empty() ) {
+            entry.function = std::move( frames[ i ].second );
+        }
+        if( i == 0 ) {
+            ++entry.function.self_samples;
+        }
+        if( entry.last_sample != m_samples ) {
+            entry.last_sample = m_samples;
+            ++entry.function.total_samples;
+        }
+    }
+    if( !line_key.empty() ) {
+        auto& entry = m_lines[ line_key ];
+        if( entry.chunk.empty() ) {
+            entry = line;
+        }
+        ++entry.samples;
+    }
+}
+
+void easy_lua_profiler::run_timer()
+{
+    std::unique_lock<std::mutex> lock( m_timer_mutex );
+    while( !m_timer_cv.wait_for( lock, m_options.interval, [ this ]() { return m_stop_timer; } ) ) {
+        m_due.store( true, std::memory_order_relaxed );
+        due_generation.fetch_add( 1, std::memory_order_relaxed );
+    }
+}
@@ -0,0 +1,244 @@
+///-------------------------------------------------------------------------------------------------
+/// Author:             ReactiioN
+/// Created:            16.10.2026
+///
+/// Last modified by:   ReactiioN
+/// Last modified on:   16.10.2026
+///-------------------------------------------------------------------------------------------------
+///     Copyright (c) ReactiioN <https://reactiion.pw>. All rights reserved.
+///-------------------------------------------------------------------------------------------------
+/// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+/// Copyright (c) 2016-2017 ReactiioN <https://reactiion.pw>.
+///-------------------------------------------------------------------------------------------------
+#pragma once
+#include "easy_lua.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// A sampling profiler for the scripts of one state. A timer thread marks a sample as due once
+/// per interval, a count hook checks the mark every 'check_instructions' VM instructions and
+/// only walks the stack when it is set, so the cost between samples is a function call and an
+/// atomic load. Samples are aggregated per function, per line and per stack; folded() exports
+/// the stacks for flamegraph.pl or speedscope.
+/// Compiled traces do not run hooks, time spent in them is attributed to the next interpreted
+/// instruction. Only time spent in scripts is sampled, idle states produce no samples.
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+class easy_lua_profiler
+{
+public:
+    struct Options
+    {
+        /// <summary>
+        /// The time between two samples.
+        /// </summary>
+        std::chrono::microseconds interval = std::chrono::microseconds( 1000 );
+        /// <summary>
+        /// The number of VM instructions between two checks for a due sample.
+        /// </summary>
+        int32_t check_instructions = 1000;
+        /// <summary>
+        /// The maximum number of frames recorded per sample, counted from the innermost.
+        /// </summary>
+        int32_t max_depth = 64;
+    };
+
+    struct Function
+    {
+        /// <summary>
+        /// The function name, e.g. "update", "main chunk" or "[C] print".
+        /// </summary>
+        std::string name;
+        /// <summary>
+        /// The chunk the function was defined in.
+        /// </summary>
+        std::string chunk;
+        /// <summary>
+        /// The line the function was defined at.
+        /// </summary>
+        int32_t line = 0;
+        /// <summary>
+        /// The number of samples the function was running in.
+        /// </summary>
+        uint64_t self_samples = 0;
+        /// <summary>
+        /// The number of samples the function was on the stack in.
+        /// </summary>
+        uint64_t total_samples = 0;
+    };
+
+    struct Line
+    {
+        /// <summary>
+        /// The chunk.
+        /// </summary>
+        std::string chunk;
+        /// <summary>
+        /// The line.
+        /// </summary>
+        int32_t line = 0;
+        /// <summary>
+        /// The number of samples the line was running in.
+        /// </summary>
+        uint64_t samples = 0;
+    };
+
+    struct Report
+    {
+        /// <summary>
+        /// The number of samples taken.
+        /// </summary>
+        uint64_t samples = 0;
+        /// <summary>
+        /// The functions by self samples, most frequent first.
+        /// </summary>
+        std::vector<Function> functions;
+        /// <summary>
+        /// The lines by samples, most frequent first.
+        /// </summary>
+        std::vector<Line> lines;
+    };
+
+public:
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Constructor. One profiler per state, the profiler is created stopped. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">  The lua. </param>
+    ///-------------------------------------------------------------------------------------------------
+    explicit easy_lua_profiler(
+        easy_lua* lua );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Constructor. One profiler per state, the profiler is created stopped. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">      The lua. </param>
+    /// <param name="options">  Options for controlling the operation. </param>
+    ///-------------------------------------------------------------------------------------------------
+    easy_lua_profiler(
+        easy_lua*      lua,
+        const Options& options );
+
+    easy_lua_profiler( const easy_lua_profiler& ) = delete;
+    easy_lua_profiler& operator = ( const easy_lua_profiler& ) = delete;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Destructor, stops the profiler. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///-------------------------------------------------------------------------------------------------
+    ~easy_lua_profiler();
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Installs the hook and starts the timer, has to be called on the thread running the state.
+    /// Fails if the state already has a hook installed.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   True if it succeeds, false if it fails. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    bool start();
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Removes the hook and stops the timer, the samples are kept. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///-------------------------------------------------------------------------------------------------
+    void stop();
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Query if the profiler is running. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   True if it is, false if not. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    bool running() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Discards the samples taken so far. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///-------------------------------------------------------------------------------------------------
+    void reset();
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the number of samples taken. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   An uint64_t. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    uint64_t samples() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Aggregates the samples into hot spots, may be called from any thread. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="limit">    (Optional) The maximum number of functions and lines, zero for all. </param>
+    ///
+    /// <returns>   The report. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    Report report(
+        size_t limit = 0 ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Exports the samples as folded stacks, one "outer;...;inner count" line per distinct stack.
+    /// May be called from any thread.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   The folded stacks. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    std::string folded() const;
+
+private:
+    struct FunctionEntry
+    {
+        Function function;
+        /// <summary>
+        /// The sample which counted total_samples last, recursion counts once per sample.
+        /// </summary>
+        uint64_t last_sample = 0;
+    };
+
+    static void hook(
+        lua_State* l,
+        lua_Debug* ar );
+
+    void sample(
+        lua_State* l );
+
+    void run_timer();
+
+private:
+    easy_lua*                                      m_lua;
+    Options                                        m_options;
+    std::weak_ptr<void>                            m_lifetime;
+    bool                                           m_tracked;
+    bool                                           m_running = false;
+    std::atomic<bool>                              m_due{ false };
+    std::thread                                    m_timer;
+    std::mutex                                     m_timer_mutex;
+    std::condition_variable                        m_timer_cv;
+    bool                                           m_stop_timer = false;
+    mutable std::mutex                             m_mutex;
+    uint64_t                                       m_samples = 0;
+    std::unordered_map<std::string, FunctionEntry> m_functions;
+    std::unordered_map<std::string, Line>          m_lines;
+    std::unordered_map<std::string, uint64_t>      m_stacks;
+};
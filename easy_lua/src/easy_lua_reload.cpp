@@ -0,0 +1,360 @@
+#include "easy_lua_reload.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    /// The address of this variable is the registry key of the module registry of a state.
+    char reload_key = 0;
+
+    int64_t last_write_time(
+        const std::string& file )
+    {
+        std::error_code ec;
+        const auto      write_time = std::filesystem::last_write_time( file, ec );
+        return ec ? 0 : static_cast<int64_t>( write_time.time_since_epoch().count() );
+    }
+
+    /// FNV-1a over the file contents, false if the file can not be read.
+    bool content_hash(
+        const std::string& file,
+        uint64_t&          hash )
+    {
+        std::ifstream stream( file, std::ios::binary );
+        if( !stream ) {
+            return false;
+        }
+        hash = 14695981039346656037ull;
+        char buffer[ 4096 ];
+        while( stream.read( buffer, sizeof( buffer ) ) || stream.gcount() > 0 ) {
+            for( std::streamsize i = 0; i < stream.gcount(); ++i ) {
+                hash ^= static_cast<uint8_t>( buffer[ i ] );
+                hash *= 1099511628211ull;
+            }
+        }
+        return true;
+    }
+}
+
+easy_lua_reload::easy_lua_reload(
+    easy_lua* lua )
+    : easy_lua_reload( lua, Options() )
+{
+}
+
+easy_lua_reload::easy_lua_reload(
+    easy_lua*      lua,
+    const Options& options )
+    : m_lua( lua )
+    , m_options( options )
+    , m_lifetime( lua->lifetime() )
+    , m_tracked( !m_lifetime.expired() )
+    , m_last_poll( std::chrono::steady_clock::now() )
+{
+#ifdef __linux__
+    if( m_options.use_inotify ) {
+        m_notify = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+    }
+#endif
+
+    const auto l = EASY_LUA_CAST_LUA( lua );
+    lua_pushlightuserdata( l, &reload_key );
+    lua_pushlightuserdata( l, this );
+    lua_rawset( l, LUA_REGISTRYINDEX );
+
+    /// The previous include stays reachable for when the registry is gone.
+    lua_getglobal( l, "include" );
+    lua_pushcclosure( l, &include, 1 );
+    lua_setglobal( l, "include" );
+}
+
+easy_lua_reload::~easy_lua_reload()
+{
+#ifdef __linux__
+    if( m_notify >= 0 ) {
+        ::close( m_notify );
+    }
+#endif
+    if( m_tracked && m_lifetime.expired() ) {
+        return;
+    }
+
+    const auto l = EASY_LUA_CAST_LUA( m_lua );
+    lua_pushlightuserdata( l, &reload_key );
+    lua_rawget( l, LUA_REGISTRYINDEX );
+    const auto registered = lua_touserdata( l, -1 ) == this;
+    lua_pop( l, 1 );
+    if( registered ) {
+        lua_pushlightuserdata( l, &reload_key );
+        lua_pushnil( l );
+        lua_rawset( l, LUA_REGISTRYINDEX );
+    }
+}
+
+bool easy_lua_reload::execute(
+    const std::string_view& file )
+{
+    if( file.empty() || ( m_tracked && m_lifetime.expired() ) ) {
+        return false;
+    }
+    return run( normalize( file ) );
+}
+
+std::vector<easy_lua_reload::Change> easy_lua_reload::poll()
+{
+    if( m_pass || !m_executing.empty() || ( m_tracked && m_lifetime.expired() ) ) {
+        return {};
+    }
+    std::unordered_set<std::string> changed;
+    collect_changes( changed );
+    return changed.empty()
+        ? std::vector<Change>()
+        : reexecute( changed );
+}
+
+std::vector<easy_lua_reload::Change> easy_lua_reload::reload(
+    const std::string_view& file )
+{
+    if( m_pass || !m_executing.empty() || ( m_tracked && m_lifetime.expired() ) ) {
+        return {};
+    }
+    auto key = normalize( file );
+    if( m_modules.find( key ) == m_modules.end() ) {
+        return {};
+    }
+    return reexecute( { std::move( key ) } );
+}
+
+std::vector<easy_lua_reload::Module> easy_lua_reload::modules() const
+{
+    std::vector<Module> result;
+    result.reserve( m_modules.size() );
+    for( const auto& [ file, entry ] : m_modules ) {
+        result.push_back( entry.module );
+    }
+    return result;
+}
+
+std::vector<std::string> easy_lua_reload::dependents(
+    const std::string_view& file ) const
+{
+    const auto               key = normalize( file );
+    std::vector<std::string> result;
+    for( const auto& [ name, entry ] : m_modules ) {
+        const auto& dependencies = entry.module.dependencies;
+        if( std::find( dependencies.begin(), dependencies.end(), key ) != dependencies.end() ) {
+            result.push_back( name );
+        }
+    }
+    return result;
+}
+
+bool easy_lua_reload::notified() const
+{
+    return m_notify >= 0;
+}
+
+int easy_lua_reload::include(
+    lua_State* l )
+{
+    lua_pushlightuserdata( l, &reload_key );
+    lua_rawget( l, LUA_REGISTRYINDEX );
+    const auto reload = static_cast<easy_lua_reload*>( lua_touserdata( l, -1 ) );
+    lua_pop( l, 1 );
+    if( !reload ) {
+        if( lua_isfunction( l, lua_upvalueindex( 1 ) ) ) {
+            lua_pushvalue( l, lua_upvalueindex( 1 ) );
+            lua_insert( l, 1 );
+            lua_call( l, lua_gettop( l ) - 1, 0 );
+        }
+        return 0;
+    }
+    if( !lua_isstring( l, 1 ) ) {
+        return 0;
+    }
+
+    const auto lua  = EASY_LUA_CAST_EASY( l );
+    const auto file = reload->normalize( lua->get_string_view( 1 ) );
+    if( !reload->m_executing.empty() ) {
+        auto& dependencies = reload->m_modules[ reload->m_executing.back() ].module.dependencies;
+        if( std::find( dependencies.begin(), dependencies.end(), file ) == dependencies.end() ) {
+            dependencies.push_back( file );
+        }
+    }
+    if( std::find( reload->m_executing.begin(), reload->m_executing.end(), file ) != reload->m_executing.end() ) {
+        return 0;
+    }
+
+    /// Modules loaded before and not changed keep their globals during a reload.
+    if( reload->m_pass
+     && reload->m_modules.find( file ) != reload->m_modules.end()
+     && reload->m_pass->pending.erase( file ) == 0 ) {
+        return 0;
+    }
+    if( !reload->run( file ) ) {
+        printf( "Failed to include file: %s\n", reload->m_modules[ file ].module.error.c_str() );
+    }
+    return 0;
+}
+
+bool easy_lua_reload::run(
+    const std::string& file )
+{
+    const auto inserted = m_modules.find( file ) == m_modules.end();
+    auto&      entry    = m_modules[ file ];
+    if( inserted ) {
+        entry.module.file = file;
+        watch( file );
+    }
+    entry.mtime = last_write_time( file );
+    content_hash( file, entry.hash );
+    entry.module.dependencies.clear();
+
+    const auto l   = EASY_LUA_CAST_LUA( m_lua );
+    const auto top = lua_gettop( l );
+    m_executing.push_back( file );
+    auto state = m_lua->load_file( file );
+    if( state == easy_lua::State_Success ) {
+        state = m_lua->pcall( 0, 0, 0 );
+    }
+    m_executing.pop_back();
+
+    const auto success = state == easy_lua::State_Success;
+    if( success ) {
+        entry.module.error.clear();
+    }
+    else {
+        const auto message = lua_tostring( l, -1 );
+        entry.module.error = message ? message : "unknown error";
+    }
+    lua_settop( l, top );
+    ++entry.module.loads;
+
+    if( m_pass ) {
+        m_pass->changes.push_back( { file, success, entry.module.error } );
+    }
+    return success;
+}
+
+std::vector<easy_lua_reload::Change> easy_lua_reload::reexecute(
+    const std::unordered_set<std::string>& changed )
+{
+    /// Dependencies first, a changed module included through an unchanged one has to be
+    /// current before the module including the unchanged one runs.
+    std::vector<std::string>                 order;
+    std::unordered_set<std::string>          visited;
+    std::function<void( const std::string& )> visit = [ & ]( const std::string& file )
+    {
+        if( !visited.insert( file ).second ) {
+            return;
+        }
+        const auto it = m_modules.find( file );
+        if( it != m_modules.end() ) {
+            for( const auto& dependency : it->second.module.dependencies ) {
+                visit( dependency );
+            }
+        }
+        if( changed.count( file ) != 0 ) {
+            order.push_back( file );
+        }
+    };
+    for( const auto& file : changed ) {
+        visit( file );
+    }
+
+    Pass pass;
+    pass.pending = changed;
+    m_pass       = &pass;
+    for( const auto& file : order ) {
+        if( pass.pending.erase( file ) != 0 ) {
+            run( file );
+        }
+    }
+    m_pass = nullptr;
+    return std::move( pass.changes );
+}
+
+void easy_lua_reload::collect_changes(
+    std::unordered_set<std::string>& changed )
+{
+    std::unordered_set<std::string> candidates;
+    auto                            check_times = m_notify < 0;
+#ifdef __linux__
+    if( m_notify >= 0 ) {
+        alignas( inotify_event ) char buffer[ 4096 ];
+        ssize_t size = 0;
+        while( ( size = read( m_notify, buffer, sizeof( buffer ) ) ) > 0 ) {
+            for( ssize_t offset = 0; offset < size; ) {
+                const auto event = reinterpret_cast<const inotify_event*>( buffer + offset );
+                offset          += static_cast<ssize_t>( sizeof( inotify_event ) + event->len );
+                if( event->mask & IN_Q_OVERFLOW ) {
+                    check_times = true;
+                    continue;
+                }
+                const auto directory = m_watches.find( event->wd );
+                if( event->len == 0 || directory == m_watches.end() ) {
+                    continue;
+                }
+                auto file = ( std::filesystem::path( directory->second ) / event->name ).string();
+                if( m_modules.find( file ) != m_modules.end() ) {
+                    candidates.insert( std::move( file ) );
+                }
+            }
+        }
+    }
+#endif
+    if( check_times ) {
+        const auto now = std::chrono::steady_clock::now();
+        if( m_notify >= 0 || now - m_last_poll >= m_options.poll_interval ) {
+            m_last_poll = now;
+            for( auto& [ file, entry ] : m_modules ) {
+                const auto mtime = last_write_time( file );
+                if( mtime != 0 && mtime != entry.mtime ) {
+                    entry.mtime = mtime;
+                    candidates.insert( file );
+                }
+            }
+        }
+    }
+
+    /// Saving without changes or touching a file does not re-execute it.
+    for( const auto& file : candidates ) {
+        auto&    entry = m_modules[ file ];
+        uint64_t hash  = 0;
+        if( content_hash( file, hash ) && hash != entry.hash ) {
+            changed.insert( file );
+        }
+    }
+}
+
+void easy_lua_reload::watch(
+    const std::string& file )
+{
+#ifdef __linux__
+    if( m_notify < 0 ) {
+        return;
+    }
+    /// Editors replace files by renaming, so the directory is watched instead of the file.
+    const auto directory = std::filesystem::path( file ).parent_path().string();
+    const auto wd        = inotify_add_watch( m_notify, directory.empty() ? "." : directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO );
+    if( wd >= 0 ) {
+        m_watches[ wd ] = directory;
+    }
+#else
+    static_cast<void>( file );
+#endif
+}
+
+std::string easy_lua_reload::normalize(
+    const std::string_view& file ) const
+{
+    const auto      resolved = m_lua->resolve_include( file );
+    std::error_code ec;
+    const auto      path     = std::filesystem::weakly_canonical( resolved, ec );
+    return ec ? resolved : path.string();
+}
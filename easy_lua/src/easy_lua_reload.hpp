@@ -0,0 +1,237 @@
+///-------------------------------------------------------------------------------------------------
+/// Author:             ReactiioN
+/// Created:            16.10.2026
+///
+/// Last modified by:   ReactiioN
+/// Last modified on:   16.10.2026
+///-------------------------------------------------------------------------------------------------
+///     Copyright (c) ReactiioN <https://reactiion.pw>. All rights reserved.
+///-------------------------------------------------------------------------------------------------
+/// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+/// Copyright (c) 2016-2017 ReactiioN <https://reactiion.pw>.
+///-------------------------------------------------------------------------------------------------
+#pragma once
+#include "easy_lua.hpp"
+#include <chrono>
+#include <unordered_map>
+#include <unordered_set>
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// Tracks the scripts of one state and re-executes changed ones without recreating the state.
+/// The registry replaces the 'include' function of the state, every file executed through it
+/// or through execute() becomes a module and the files it includes become its dependencies.
+/// poll() detects changed modules, through inotify on Linux and by polling the last write
+/// time elsewhere, and runs only their chunks again, dependencies before dependents. While a
+/// module is re-executed its includes of unchanged modules are skipped, so globals defined by
+/// other modules are kept. Locals captured from a changed module by an unchanged one keep the
+/// old values until that module is reloaded as well.
+/// Everything has to be used on the thread owning the state.
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+class easy_lua_reload
+{
+public:
+    struct Options
+    {
+        /// <summary>
+        /// The minimum time between two last write time checks without inotify.
+        /// </summary>
+        std::chrono::milliseconds poll_interval = std::chrono::milliseconds( 250 );
+        /// <summary>
+        /// False to poll the last write times on Linux as well.
+        /// </summary>
+        bool use_inotify = true;
+    };
+
+    struct Module
+    {
+        /// <summary>
+        /// The normalized path of the file.
+        /// </summary>
+        std::string file;
+        /// <summary>
+        /// The modules included by the last execution, in include order.
+        /// </summary>
+        std::vector<std::string> dependencies;
+        /// <summary>
+        /// The number of executions.
+        /// </summary>
+        uint64_t loads = 0;
+        /// <summary>
+        /// The error of the last execution, empty if it succeeded.
+        /// </summary>
+        std::string error;
+    };
+
+    struct Change
+    {
+        /// <summary>
+        /// The normalized path of the re-executed file.
+        /// </summary>
+        std::string file;
+        /// <summary>
+        /// True if the chunk loaded and ran without errors.
+        /// </summary>
+        bool success = false;
+        /// <summary>
+        /// The error message if it failed.
+        /// </summary>
+        std::string error;
+    };
+
+public:
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Constructor. One registry per state, create it before the scripts run since earlier
+    /// includes are not tracked.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">  The lua. </param>
+    ///-------------------------------------------------------------------------------------------------
+    explicit easy_lua_reload(
+        easy_lua* lua );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Constructor. One registry per state, create it before the scripts run since earlier
+    /// includes are not tracked.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">      The lua. </param>
+    /// <param name="options">  Options for controlling the operation. </param>
+    ///-------------------------------------------------------------------------------------------------
+    easy_lua_reload(
+        easy_lua*      lua,
+        const Options& options );
+
+    easy_lua_reload( const easy_lua_reload& ) = delete;
+    easy_lua_reload& operator = ( const easy_lua_reload& ) = delete;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Destructor, 'include' falls back to executing files untracked. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///-------------------------------------------------------------------------------------------------
+    ~easy_lua_reload();
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Executes a script file resolved like 'include' and tracks it as a module. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="file"> The file. </param>
+    ///
+    /// <returns>   True if it succeeds, false if it fails. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    bool execute(
+        const std::string_view& file );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Re-executes the modules whose contents changed since their last execution. Cheap when
+    /// nothing changed, meant to be called once per frame or tick.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   The re-executed modules in the order they finished, dependencies first. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    std::vector<Change> poll();
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Re-executes a tracked module whether or not it changed. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="file"> The file. </param>
+    ///
+    /// <returns>   The re-executed modules, empty if 'file' is not tracked. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    std::vector<Change> reload(
+        const std::string_view& file );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the tracked modules. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   The modules. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    std::vector<Module> modules() const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the tracked modules which include 'file'. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="file"> The file. </param>
+    ///
+    /// <returns>   The normalized paths of the dependents. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    std::vector<std::string> dependents(
+        const std::string_view& file ) const;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Query if changes are detected through inotify instead of polling. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   True if it is, false if not. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    bool notified() const;
+
+private:
+    struct Entry
+    {
+        Module   module;
+        int64_t  mtime = 0;
+        uint64_t hash  = 0;
+    };
+
+    struct Pass
+    {
+        /// <summary>
+        /// The changed modules which were not executed yet.
+        /// </summary>
+        std::unordered_set<std::string> pending;
+        std::vector<Change>             changes;
+    };
+
+    static int include(
+        lua_State* l );
+
+    bool run(
+        const std::string& file );
+
+    std::vector<Change> reexecute(
+        const std::unordered_set<std::string>& changed );
+
+    void collect_changes(
+        std::unordered_set<std::string>& changed );
+
+    void watch(
+        const std::string& file );
+
+    std::string normalize(
+        const std::string_view& file ) const;
+
+private:
+    easy_lua*                                    m_lua;
+    Options                                      m_options;
+    std::weak_ptr<void>                          m_lifetime;
+    bool                                         m_tracked;
+    std::unordered_map<std::string, Entry>       m_modules;
+    /// <summary>
+    /// The modules being executed, innermost last.
+    /// </summary>
+    std::vector<std::string>                     m_executing;
+    Pass*                                        m_pass    = nullptr;
+    int32_t                                      m_notify  = -1;
+    std::unordered_map<int32_t, std::string>     m_watches;
+    std::chrono::steady_clock::time_point        m_last_poll;
+};
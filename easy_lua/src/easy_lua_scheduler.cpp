@@ -0,0 +1,270 @@
+#include "easy_lua_scheduler.hpp"
+
+namespace {
+    /// The address of this variable is the registry key of the scheduler of a state.
+    char scheduler_key = 0;
+}
+
+bool easy_lua_scheduler::Pending::complete(
+    FnPush push ) const
+{
+    const auto inbox = m_inbox.lock();
+    if( !inbox ) {
+        return false;
+    }
+    FnWake wake;
+    {
+        std::lock_guard<std::mutex> lock( inbox->mutex );
+        inbox->completions.push_back( Completion{ m_task, m_operation, std::move( push ) } );
+        wake = inbox->wake;
+    }
+    if( wake ) {
+        wake();
+    }
+    return true;
+}
+
+int32_t easy_lua_scheduler::Pending::yield() const
+{
+    return lua_yield( m_thread, 0 );
+}
+
+easy_lua_scheduler::TaskId easy_lua_scheduler::Pending::task() const
+{
+    return m_task;
+}
+
+easy_lua_scheduler::Pending::operator bool() const
+{
+    return m_task != 0;
+}
+
+easy_lua_scheduler::easy_lua_scheduler(
+    easy_lua* lua,
+    FnWake    wake )
+    : m_lua( lua )
+    , m_lifetime( lua->lifetime() )
+    , m_tracked( !m_lifetime.expired() )
+    , m_inbox( std::make_shared<Inbox>() )
+{
+    m_inbox->wake = std::move( wake );
+
+    const auto l = EASY_LUA_CAST_LUA( lua );
+    lua_pushlightuserdata( l, &scheduler_key );
+    lua_pushlightuserdata( l, this );
+    lua_rawset( l, LUA_REGISTRYINDEX );
+}
+
+easy_lua_scheduler::~easy_lua_scheduler()
+{
+    if( m_tracked && m_lifetime.expired() ) {
+        /// The state was closed first, its registry is gone.
+        return;
+    }
+
+    const auto l = EASY_LUA_CAST_LUA( m_lua );
+    for( const auto& [ id, task ] : m_tasks ) {
+        luaL_unref( l, LUA_REGISTRYINDEX, task.reference );
+    }
+    lua_pushlightuserdata( l, &scheduler_key );
+    lua_rawget( l, LUA_REGISTRYINDEX );
+    const auto registered = lua_touserdata( l, -1 ) == this;
+    lua_pop( l, 1 );
+    if( registered ) {
+        lua_pushlightuserdata( l, &scheduler_key );
+        lua_pushnil( l );
+        lua_rawset( l, LUA_REGISTRYINDEX );
+    }
+}
+
+easy_lua_scheduler::TaskId easy_lua_scheduler::spawn_chunk(
+    const std::string_view& source,
+    const std::string_view& chunk_name )
+{
+    const auto l = EASY_LUA_CAST_LUA( m_lua );
+    if( m_lua->load_buffer( source, chunk_name ) != easy_lua::State_Success ) {
+        lua_pop( l, 1 );
+        return 0;
+    }
+
+    TaskId     task   = 0;
+    const auto thread = create_thread( task );
+    lua_xmove( l, thread, 1 );
+    return start( task, 0 );
+}
+
+easy_lua_scheduler::Pending easy_lua_scheduler::suspend(
+    easy_lua* lua )
+{
+    const auto l = EASY_LUA_CAST_LUA( lua );
+    lua_pushlightuserdata( l, &scheduler_key );
+    lua_rawget( l, LUA_REGISTRYINDEX );
+    const auto scheduler = static_cast<easy_lua_scheduler*>( lua_touserdata( l, -1 ) );
+    lua_pop( l, 1 );
+
+    Pending pending;
+    if( !scheduler ) {
+        return pending;
+    }
+    const auto thread = scheduler->m_threads.find( l );
+    if( thread == scheduler->m_threads.end() ) {
+        return pending;
+    }
+    auto& task = scheduler->m_tasks.at( thread->second );
+    if( task.waiting ) {
+        return pending;
+    }
+
+    task.waiting         = true;
+    pending.m_inbox      = scheduler->m_inbox;
+    pending.m_thread     = l;
+    pending.m_task       = thread->second;
+    pending.m_operation  = ++task.operation;
+    return pending;
+}
+
+size_t easy_lua_scheduler::poll(
+    const size_t max_resumes )
+{
+    std::vector<Completion> completions;
+    {
+        std::lock_guard<std::mutex> lock( m_inbox->mutex );
+        completions.swap( m_inbox->completions );
+    }
+    std::vector<TaskId> ready;
+    ready.swap( m_ready );
+
+    size_t resumed = 0;
+    size_t index   = 0;
+    for( ; index < ready.size() && resumed < max_resumes; ++index ) {
+        const auto it = m_tasks.find( ready[ index ] );
+        if( it != m_tasks.end() && !it->second.waiting ) {
+            resume( ready[ index ], 0 );
+            ++resumed;
+        }
+    }
+    /// Tasks which yielded during this poll were appended to m_ready, keep the older ones first.
+    m_ready.insert( m_ready.begin(), ready.begin() + static_cast<ptrdiff_t>( index ), ready.end() );
+
+    index = 0;
+    for( ; index < completions.size() && resumed < max_resumes; ++index ) {
+        auto&      completion = completions[ index ];
+        const auto it         = m_tasks.find( completion.task );
+        if( it == m_tasks.end() || !it->second.waiting || it->second.operation != completion.operation ) {
+            continue;
+        }
+
+        it->second.waiting  = false;
+        const auto thread   = it->second.thread;
+        const auto num_args = completion.push
+            ? completion.push( EASY_LUA_CAST_EASY( thread ) )
+            : 0;
+        resume( completion.task, num_args );
+        ++resumed;
+    }
+    if( index < completions.size() ) {
+        std::lock_guard<std::mutex> lock( m_inbox->mutex );
+        m_inbox->completions.insert(
+            m_inbox->completions.begin(),
+            std::make_move_iterator( completions.begin() + static_cast<ptrdiff_t>( index ) ),
+            std::make_move_iterator( completions.end() )
+        );
+    }
+    return resumed;
+}
+
+bool easy_lua_scheduler::cancel(
+    const TaskId task )
+{
+    const auto it = m_tasks.find( task );
+    if( it == m_tasks.end() ) {
+        return false;
+    }
+    luaL_unref( EASY_LUA_CAST_LUA( m_lua ), LUA_REGISTRYINDEX, it->second.reference );
+    m_threads.erase( it->second.thread );
+    m_tasks.erase( it );
+    return true;
+}
+
+void easy_lua_scheduler::on_done(
+    FnDone done )
+{
+    m_done = std::move( done );
+}
+
+size_t easy_lua_scheduler::active() const
+{
+    return m_tasks.size();
+}
+
+lua_State* easy_lua_scheduler::create_thread(
+    TaskId& task )
+{
+    const auto l      = EASY_LUA_CAST_LUA( m_lua );
+    const auto thread = lua_newthread( l );
+    const auto ref    = luaL_ref( l, LUA_REGISTRYINDEX );
+    task              = m_next_task++;
+    m_tasks.emplace( task, Task{ thread, ref, 0, false } );
+    m_threads.emplace( thread, task );
+    return thread;
+}
+
+easy_lua_scheduler::TaskId easy_lua_scheduler::start(
+    const TaskId  task,
+    const int32_t num_args )
+{
+    resume( task, num_args );
+    return task;
+}
+
+void easy_lua_scheduler::resume(
+    const TaskId  task,
+    const int32_t num_args )
+{
+    const auto thread = m_tasks.at( task ).thread;
+    const auto status = lua_resume( thread, num_args );
+
+    /// The task may have spawned or cancelled tasks meanwhile, look it up again.
+    const auto it = m_tasks.find( task );
+    if( it == m_tasks.end() ) {
+        return;
+    }
+    if( status == LUA_YIELD ) {
+        if( !it->second.waiting ) {
+            /// coroutine.yield() from the script, continue on the next poll.
+            lua_settop( thread, 0 );
+            m_ready.push_back( task );
+        }
+        return;
+    }
+
+    easy_lua_result<> result;
+    switch( status ) {
+    case 0:
+        break;
+    case LUA_ERRMEM:
+        result.state = easy_lua::State_MemAlloc;
+        break;
+    case LUA_ERRERR:
+        result.state = easy_lua::State_ErrHandling;
+        break;
+    default:
+        result.state = easy_lua::State_Runtime;
+        break;
+    }
+    if( result.state != easy_lua::State_Success ) {
+        const auto lua = EASY_LUA_CAST_EASY( thread );
+        result.error.assign( lua->get_string_view( -1 ) );
+    }
+    finish( task, result );
+}
+
+void easy_lua_scheduler::finish(
+    const TaskId             task,
+    const easy_lua_result<>& result )
+{
+    cancel( task );
+    if( m_done ) {
+        m_done( task, result );
+    }
+}
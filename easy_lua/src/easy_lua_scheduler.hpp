@@ -0,0 +1,293 @@
+///-------------------------------------------------------------------------------------------------
+/// Author:             ReactiioN
+/// Created:            16.10.2026
+///
+/// Last modified by:   ReactiioN
+/// Last modified on:   16.10.2026
+///-------------------------------------------------------------------------------------------------
+///     Copyright (c) ReactiioN <https://reactiion.pw>. All rights reserved.
+///-------------------------------------------------------------------------------------------------
+/// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+/// Copyright (c) 2016-2017 ReactiioN <https://reactiion.pw>.
+///-------------------------------------------------------------------------------------------------
+#pragma once
+#include "easy_lua.hpp"
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// Runs script tasks as coroutines of one state. An exported callback suspends its task with
+///     auto pending = easy_lua_scheduler::suspend( lua );
+///     start_io( ..., [ pending ]( ... ) { pending.complete( push_results ); } );
+///     return pending.yield();
+/// and the task continues with the pushed values as results of the callback once poll runs
+/// after the completion. A task calling coroutine.yield() is resumed by the next poll.
+/// Everything but Pending::complete has to be used on the thread owning the state.
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+class easy_lua_scheduler
+{
+public:
+    /// <summary>
+    /// The task identifier typedef, zero is never used.
+    /// </summary>
+    using TaskId = uint64_t;
+    /// <summary>
+    /// Pushes the results of a completed operation onto the task and returns their number.
+    /// </summary>
+    using FnPush = std::function<int32_t( easy_lua* )>;
+    /// <summary>
+    /// Called from the completing thread whenever a completion was queued, e.g. to wake the event loop.
+    /// </summary>
+    using FnWake = std::function<void()>;
+    /// <summary>
+    /// Called when a task returned or failed.
+    /// </summary>
+    using FnDone = std::function<void( TaskId, const easy_lua_result<>& )>;
+
+private:
+    struct Completion
+    {
+        TaskId   task;
+        uint64_t operation;
+        FnPush   push;
+    };
+
+    struct Inbox
+    {
+        std::mutex              mutex;
+        std::vector<Completion> completions;
+        FnWake                  wake;
+    };
+
+public:
+    class Pending
+    {
+        friend class easy_lua_scheduler;
+
+    public:
+        Pending() = default;
+
+        ///-------------------------------------------------------------------------------------------------
+        /// <summary>
+        /// Queues the completion of the operation, may be called from any thread. Completions of
+        /// cancelled tasks and repeated completions are dropped by poll.
+        /// </summary>
+        ///
+        /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+        ///
+        /// <param name="push"> (Optional) Pushes the results of the suspended callback. </param>
+        ///
+        /// <returns>   True if it succeeds, false if the scheduler is gone. </returns>
+        ///-------------------------------------------------------------------------------------------------
+        bool complete(
+            FnPush push = nullptr ) const;
+
+        ///-------------------------------------------------------------------------------------------------
+        /// <summary>
+        /// Yields the task, the callback has to return the result: return pending.yield();
+        /// </summary>
+        ///
+        /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+        ///
+        /// <returns>   The value the lua_CFunction has to return. </returns>
+        ///-------------------------------------------------------------------------------------------------
+        int32_t yield() const;
+
+        ///-------------------------------------------------------------------------------------------------
+        /// <summary>   Gets the suspended task. </summary>
+        ///
+        /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+        ///
+        /// <returns>   Zero if empty, else the task identifier. </returns>
+        ///-------------------------------------------------------------------------------------------------
+        TaskId task() const;
+
+        explicit operator bool() const;
+
+    private:
+        std::weak_ptr<Inbox> m_inbox;
+        lua_State*           m_thread    = nullptr;
+        TaskId               m_task      = 0;
+        uint64_t             m_operation = 0;
+    };
+
+public:
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Constructor. One scheduler per state. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">  The lua. </param>
+    /// <param name="wake"> (Optional) The wake callback. </param>
+    ///-------------------------------------------------------------------------------------------------
+    explicit easy_lua_scheduler(
+        easy_lua* lua,
+        FnWake    wake = nullptr );
+
+    easy_lua_scheduler( const easy_lua_scheduler& ) = delete;
+    easy_lua_scheduler& operator = ( const easy_lua_scheduler& ) = delete;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Destructor. Drops every unfinished task. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///-------------------------------------------------------------------------------------------------
+    ~easy_lua_scheduler();
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Starts the global function 'function' as a task. It runs until it suspends or returns
+    /// before spawn returns.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <typeparam name="Args">     The argument types. </typeparam>
+    /// <param name="function"> The global name of the function. </param>
+    /// <param name="args">     The arguments. </param>
+    ///
+    /// <returns>   Zero if 'function' is not a function, else the task identifier. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    template<typename... Args>
+    TaskId spawn(
+        const std::string_view& function,
+        const Args&...          args );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Starts an in-memory script as a task, see spawn. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="source">       The source. </param>
+    /// <param name="chunk_name">   (Optional) The chunk name used in messages. </param>
+    ///
+    /// <returns>   Zero if the script does not compile, else the task identifier. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    TaskId spawn_chunk(
+        const std::string_view& source,
+        const std::string_view& chunk_name = "=task" );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>
+    /// Suspends the task running the calling callback. Returns an empty handle if the callback
+    /// does not run inside a task of a scheduler.
+    /// </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="lua">  The lua passed to the callback. </param>
+    ///
+    /// <returns>   The pending operation. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    static Pending suspend(
+        easy_lua* lua );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Resumes the tasks whose operation completed or which yielded. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="max_resumes">  (Optional) The maximum number of resumes. </param>
+    ///
+    /// <returns>   The number of resumed tasks. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    size_t poll(
+        size_t max_resumes = std::numeric_limits<size_t>::max() );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Drops a task, a pending completion of it is ignored. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="task"> The task. </param>
+    ///
+    /// <returns>   True if it succeeds, false if the task does not exist. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    bool cancel(
+        TaskId task );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Sets the callback invoked when a task finished. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <param name="done"> The done callback. </param>
+    ///-------------------------------------------------------------------------------------------------
+    void on_done(
+        FnDone done );
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Gets the number of unfinished tasks. </summary>
+    ///
+    /// <remarks>   ReactiioN, 16.10.2026. </remarks>
+    ///
+    /// <returns>   A size_t. </returns>
+    ///-------------------------------------------------------------------------------------------------
+    size_t active() const;
+
+private:
+    struct Task
+    {
+        lua_State* thread;
+        int32_t    reference;
+        uint64_t   operation;
+        bool       waiting;
+    };
+
+    lua_State* create_thread(
+        TaskId& task );
+
+    TaskId start(
+        TaskId  task,
+        int32_t num_args );
+
+    void resume(
+        TaskId  task,
+        int32_t num_args );
+
+    void finish(
+        TaskId                   task,
+        const easy_lua_result<>& result );
+
+private:
+    easy_lua*                              m_lua;
+    std::weak_ptr<void>                    m_lifetime;
+    bool                                   m_tracked;
+    std::shared_ptr<Inbox>                 m_inbox;
+    std::unordered_map<TaskId, Task>       m_tasks;
+    std::unordered_map<lua_State*, TaskId> m_threads;
+    std::vector<TaskId>                    m_ready;
+    FnDone                                 m_done;
+    TaskId                                 m_next_task = 1;
+};
+
+template<typename... Args>
+easy_lua_scheduler::TaskId easy_lua_scheduler::spawn(
+    const std::string_view& function,
+    const Args&...          args )
+{
+    const auto l = EASY_LUA_CAST_LUA( m_lua );
+    m_lua->get_global( function );
+    if( !lua_isfunction( l, -1 ) ) {
+        lua_pop( l, 1 );
+        return 0;
+    }
+
+    TaskId     task   = 0;
+    const auto thread = create_thread( task );
+    if( !thread ) {
+        lua_pop( l, 1 );
+        return 0;
+    }
+    lua_xmove( l, thread, 1 );
+    if( !lua_checkstack( thread, static_cast<int32_t>( sizeof...( Args ) ) ) ) {
+        cancel( task );
+        return 0;
+    }
+    const auto num_args = ( 0 + ... + easy_lua_stack<std::decay_t<Args>>::push( thread, args ) );
+    return start( task, num_args );
+}
@@ -0,0 +1,863 @@
+///-------------------------------------------------------------------------------------------------
+/// Author:             ReactiioN
+/// Created:            16.10.2026
+///
+/// Last modified by:   ReactiioN
+/// Last modified on:   16.10.2026
+///-------------------------------------------------------------------------------------------------
+///     Copyright (c) ReactiioN <https://reactiion.pw>. All rights reserved.
+///-------------------------------------------------------------------------------------------------
+/// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+/// Copyright (c) 2016-2017 ReactiioN <https://reactiion.pw>.
+///-------------------------------------------------------------------------------------------------
+#pragma once
+#if defined(EASY_LUA_STATIC)
+#include "LuaJIT/lua.hpp"
+#else
+#include <lua.hpp>
+#endif
+#include <array>
+#include <cstdint>
+#include <map>
+#include <new>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// Converts T from and to the lua stack. Every specialization provides
+///     static constexpr const char* name;
+///     static bool    check( lua_State* l, int32_t stackpos );
+///     static T       get( lua_State* l, int32_t stackpos );
+///     static int32_t push( lua_State* l, const T& value );
+/// where push returns the number of pushed values.
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+template<typename T, typename = void>
+struct easy_lua_stack;
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// Describes the fields of a struct converted from and to a lua table. Specializations provide
+///     static constexpr const char* name;
+///     static constexpr auto        fields = std::make_tuple( easy_lua_field( "x", &T::x ), ... );
+/// usually through EASY_LUA_REFLECT.
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+template<typename T>
+struct easy_lua_reflect;
+
+template<typename C, typename M>
+struct easy_lua_field_info
+{
+    const char* name;
+    M C::*      member;
+};
+
+template<typename C, typename M>
+constexpr easy_lua_field_info<C, M> easy_lua_field(
+    const char* name,
+    M C::*      member )
+{
+    return easy_lua_field_info<C, M>{ name, member };
+}
+
+#if !defined(EASY_LUA_REFLECT_FIELD)
+#define EASY_LUA_REFLECT_FIELD(type, member) easy_lua_field( #member, &type::member )
+#endif
+
+#if !defined(EASY_LUA_REFLECT)
+#define EASY_LUA_REFLECT(type, ...) template<>                  \
+    struct easy_lua_reflect<type>                               \
+    {                                                           \
+        static constexpr const char* name   = #type;            \
+        static constexpr auto        fields = std::make_tuple(  \
+            __VA_ARGS__                                         \
+        );                                                      \
+    }
+#endif
+
+template<typename T, typename = void>
+struct easy_lua_is_reflected
+    : std::false_type
+{
+};
+
+template<typename T>
+struct easy_lua_is_reflected<T, std::void_t<decltype( easy_lua_reflect<T>::fields )>>
+    : std::true_type
+{
+};
+
+template<typename T, typename = void>
+struct easy_lua_has_read
+    : std::false_type
+{
+};
+
+template<typename T>
+struct easy_lua_has_read<T, std::void_t<decltype( &easy_lua_stack<T>::read )>>
+    : std::true_type
+{
+};
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// Strict conversion used by the table readers: containers validate every element, plain values
+/// are checked before they are read. 'value' is left untouched if the check fails.
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+template<typename T>
+bool easy_lua_read(
+    lua_State*    l,
+    const int32_t stackpos,
+    T&            value )
+{
+    if constexpr( easy_lua_has_read<T>::value ) {
+        return easy_lua_stack<T>::read( l, stackpos, value );
+    }
+    else {
+        if( !easy_lua_stack<T>::check( l, stackpos ) ) {
+            return false;
+        }
+        value = easy_lua_stack<T>::get( l, stackpos );
+        return true;
+    }
+}
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>   Converts a relative stackpos into an absolute one, pseudo indices are kept. </summary>
+///-------------------------------------------------------------------------------------------------
+inline int32_t easy_lua_absolute(
+    lua_State*    l,
+    const int32_t stackpos )
+{
+    return stackpos < 0 && stackpos > LUA_REGISTRYINDEX
+        ? lua_gettop( l ) + stackpos + 1
+        : stackpos;
+}
+
+template<>
+struct easy_lua_stack<bool>
+{
+    static constexpr const char* name = "boolean";
+
+    static bool check(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        return lua_isboolean( l, stackpos );
+    }
+
+    static bool get(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        return lua_toboolean( l, stackpos ) != 0;
+    }
+
+    static int32_t push(
+        lua_State* l,
+        const bool value )
+    {
+        lua_pushboolean( l, value ? 1 : 0 );
+        return 1;
+    }
+};
+
+template<typename T>
+struct easy_lua_stack<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+{
+    static constexpr const char* name = "number";
+
+    static bool check(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        return lua_isnumber( l, stackpos ) != 0;
+    }
+
+    static T get(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        return static_cast<T>( lua_tointeger( l, stackpos ) );
+    }
+
+    static int32_t push(
+        lua_State* l,
+        const T    value )
+    {
+        lua_pushnumber( l, static_cast<lua_Number>( value ) );
+        return 1;
+    }
+};
+
+template<typename T>
+struct easy_lua_stack<T, std::enable_if_t<std::is_floating_point_v<T>>>
+{
+    static constexpr const char* name = "number";
+
+    static bool check(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        return lua_isnumber( l, stackpos ) != 0;
+    }
+
+    static T get(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        return static_cast<T>( lua_tonumber( l, stackpos ) );
+    }
+
+    static int32_t push(
+        lua_State* l,
+        const T    value )
+    {
+        lua_pushnumber( l, static_cast<lua_Number>( value ) );
+        return 1;
+    }
+};
+
+template<typename T>
+struct easy_lua_stack<T, std::enable_if_t<std::is_enum_v<T>>>
+{
+    using underlying = std::underlying_type_t<T>;
+
+    static constexpr const char* name = "number";
+
+    static bool check(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        return lua_isnumber( l, stackpos ) != 0;
+    }
+
+    static T get(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        return static_cast<T>( lua_tointeger( l, stackpos ) );
+    }
+
+    static int32_t push(
+        lua_State* l,
+        const T    value )
+    {
+        lua_pushnumber( l, static_cast<lua_Number>( static_cast<underlying>( value ) ) );
+        return 1;
+    }
+};
+
+template<>
+struct easy_lua_stack<std::string_view>
+{
+    static constexpr const char* name = "string";
+
+    static bool check(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        return lua_isstring( l, stackpos ) != 0;
+    }
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   The view stays valid as long as the value is on the stack. </summary>
+    ///-------------------------------------------------------------------------------------------------
+    static std::string_view get(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        size_t     length = 0;
+        const auto buffer = lua_tolstring( l, stackpos, &length );
+        return std::string_view( buffer, length );
+    }
+
+    static int32_t push(
+        lua_State*              l,
+        const std::string_view& value )
+    {
+        lua_pushlstring( l, value.data(), value.size() );
+        return 1;
+    }
+};
+
+template<>
+struct easy_lua_stack<std::string>
+{
+    static constexpr const char* name = "string";
+
+    static bool check(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        return lua_isstring( l, stackpos ) != 0;
+    }
+
+    static std::string get(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        return std::string( easy_lua_stack<std::string_view>::get( l, stackpos ) );
+    }
+
+    static int32_t push(
+        lua_State*         l,
+        const std::string& value )
+    {
+        lua_pushlstring( l, value.data(), value.size() );
+        return 1;
+    }
+};
+
+template<>
+struct easy_lua_stack<const char*>
+{
+    static constexpr const char* name = "string";
+
+    static bool check(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        return lua_isstring( l, stackpos ) != 0;
+    }
+
+    static const char* get(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        return lua_tostring( l, stackpos );
+    }
+
+    static int32_t push(
+        lua_State*  l,
+        const char* value )
+    {
+        if( value ) {
+            lua_pushstring( l, value );
+        }
+        else {
+            lua_pushnil( l );
+        }
+        return 1;
+    }
+};
+
+template<typename... Ts>
+struct easy_lua_stack<std::tuple<Ts...>>
+{
+    static int32_t push(
+        lua_State*                l,
+        const std::tuple<Ts...>& value )
+    {
+        return std::apply( [ l ]( const Ts&... values ) -> int32_t
+        {
+            return ( 0 + ... + easy_lua_stack<std::decay_t<Ts>>::push( l, values ) );
+        }, value );
+    }
+};
+
+template<typename A, typename B>
+struct easy_lua_stack<std::pair<A, B>>
+{
+    static int32_t push(
+        lua_State*               l,
+        const std::pair<A, B>& value )
+    {
+        return easy_lua_stack<std::decay_t<A>>::push( l, value.first )
+             + easy_lua_stack<std::decay_t<B>>::push( l, value.second );
+    }
+};
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// Array tables. Pushing presizes the array part and fills it with lua_rawseti, reading walks
+/// 1..#t. get converts elements leniently, read rejects the table on the first bad element.
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+template<typename T, typename A>
+struct easy_lua_stack<std::vector<T, A>>
+{
+    static constexpr const char* name = "table";
+
+    static bool check(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        return lua_istable( l, stackpos );
+    }
+
+    static bool read(
+        lua_State*         l,
+        const int32_t      stackpos,
+        std::vector<T, A>& value )
+    {
+        if( !lua_istable( l, stackpos ) ) {
+            return false;
+        }
+        const auto table = easy_lua_absolute( l, stackpos );
+        const auto count = static_cast<int32_t>( lua_objlen( l, table ) );
+        std::vector<T, A> result;
+        result.reserve( static_cast<size_t>( count ) );
+        for( int32_t i = 1; i <= count; ++i ) {
+            lua_rawgeti( l, table, i );
+            T element{};
+            const auto valid = easy_lua_read( l, -1, element );
+            lua_pop( l, 1 );
+            if( !valid ) {
+                return false;
+            }
+            result.push_back( std::move( element ) );
+        }
+        value = std::move( result );
+        return true;
+    }
+
+    static std::vector<T, A> get(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        std::vector<T, A> result;
+        if( !lua_istable( l, stackpos ) ) {
+            return result;
+        }
+        const auto table = easy_lua_absolute( l, stackpos );
+        const auto count = static_cast<int32_t>( lua_objlen( l, table ) );
+        result.reserve( static_cast<size_t>( count ) );
+        for( int32_t i = 1; i <= count; ++i ) {
+            lua_rawgeti( l, table, i );
+            result.push_back( easy_lua_stack<T>::get( l, -1 ) );
+            lua_pop( l, 1 );
+        }
+        return result;
+    }
+
+    static int32_t push(
+        lua_State*               l,
+        const std::vector<T, A>& value )
+    {
+        luaL_checkstack( l, 3, "table nesting too deep" );
+        lua_createtable( l, static_cast<int32_t>( value.size() ), 0 );
+        int32_t index = 0;
+        for( const auto& element : value ) {
+            easy_lua_stack<T>::push( l, element );
+            lua_rawseti( l, -2, ++index );
+        }
+        return 1;
+    }
+};
+
+template<typename T, size_t N>
+struct easy_lua_stack<std::array<T, N>>
+{
+    static constexpr const char* name = "table";
+
+    static bool check(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        return lua_istable( l, stackpos );
+    }
+
+    static bool read(
+        lua_State*        l,
+        const int32_t     stackpos,
+        std::array<T, N>& value )
+    {
+        if( !lua_istable( l, stackpos ) || lua_objlen( l, stackpos ) < N ) {
+            return false;
+        }
+        const auto       table  = easy_lua_absolute( l, stackpos );
+        std::array<T, N> result = value;
+        for( size_t i = 0; i < N; ++i ) {
+            lua_rawgeti( l, table, static_cast<int32_t>( i + 1 ) );
+            const auto valid = easy_lua_read( l, -1, result[ i ] );
+            lua_pop( l, 1 );
+            if( !valid ) {
+                return false;
+            }
+        }
+        value = std::move( result );
+        return true;
+    }
+
+    static std::array<T, N> get(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        std::array<T, N> result{};
+        if( !lua_istable( l, stackpos ) ) {
+            return result;
+        }
+        const auto table = easy_lua_absolute( l, stackpos );
+        for( size_t i = 0; i < N; ++i ) {
+            lua_rawgeti( l, table, static_cast<int32_t>( i + 1 ) );
+            result[ i ] = easy_lua_stack<T>::get( l, -1 );
+            lua_pop( l, 1 );
+        }
+        return result;
+    }
+
+    static int32_t push(
+        lua_State*              l,
+        const std::array<T, N>& value )
+    {
+        luaL_checkstack( l, 3, "table nesting too deep" );
+        lua_createtable( l, static_cast<int32_t>( N ), 0 );
+        for( size_t i = 0; i < N; ++i ) {
+            easy_lua_stack<T>::push( l, value[ i ] );
+            lua_rawseti( l, -2, static_cast<int32_t>( i + 1 ) );
+        }
+        return 1;
+    }
+};
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// Hash tables. Keys are converted from a copy, lua_tolstring would otherwise turn number keys
+/// into strings in place and break lua_next.
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+template<typename Map>
+struct easy_lua_map_stack
+{
+    using key_type    = typename Map::key_type;
+    using mapped_type = typename Map::mapped_type;
+
+    static constexpr const char* name = "table";
+
+    static bool check(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        return lua_istable( l, stackpos );
+    }
+
+    static bool read(
+        lua_State*    l,
+        const int32_t stackpos,
+        Map&          value )
+    {
+        if( !lua_istable( l, stackpos ) ) {
+            return false;
+        }
+        const auto table = easy_lua_absolute( l, stackpos );
+        Map        result;
+        lua_pushnil( l );
+        while( lua_next( l, table ) != 0 ) {
+            key_type    key{};
+            mapped_type mapped{};
+            lua_pushvalue( l, -2 );
+            const auto valid = easy_lua_read( l, -1, key ) && easy_lua_read( l, -2, mapped );
+            lua_pop( l, 2 );
+            if( !valid ) {
+                lua_pop( l, 1 );
+                return false;
+            }
+            result.emplace( std::move( key ), std::move( mapped ) );
+        }
+        value = std::move( result );
+        return true;
+    }
+
+    static Map get(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        Map result;
+        read( l, stackpos, result );
+        return result;
+    }
+
+    static int32_t push(
+        lua_State* l,
+        const Map& value )
+    {
+        luaL_checkstack( l, 4, "table nesting too deep" );
+        lua_createtable( l, 0, static_cast<int32_t>( value.size() ) );
+        for( const auto& [ key, mapped ] : value ) {
+            easy_lua_stack<key_type>::push( l, key );
+            easy_lua_stack<mapped_type>::push( l, mapped );
+            lua_rawset( l, -3 );
+        }
+        return 1;
+    }
+};
+
+template<typename K, typename V, typename C, typename A>
+struct easy_lua_stack<std::map<K, V, C, A>>
+    : easy_lua_map_stack<std::map<K, V, C, A>>
+{
+};
+
+template<typename K, typename V, typename H, typename E, typename A>
+struct easy_lua_stack<std::unordered_map<K, V, H, E, A>>
+    : easy_lua_map_stack<std::unordered_map<K, V, H, E, A>>
+{
+};
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// Reflected structs are tables keyed by the field names. Missing fields keep their value when
+/// reading, a field of the wrong type rejects the table.
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+template<typename T>
+struct easy_lua_stack<T, std::enable_if_t<easy_lua_is_reflected<T>::value>>
+{
+    static constexpr const char* name = easy_lua_reflect<T>::name;
+
+    static bool check(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        return lua_istable( l, stackpos );
+    }
+
+    static bool read(
+        lua_State*    l,
+        const int32_t stackpos,
+        T&            value )
+    {
+        if( !lua_istable( l, stackpos ) ) {
+            return false;
+        }
+        const auto table  = easy_lua_absolute( l, stackpos );
+        T          result = value;
+        const auto valid  = std::apply( [ l, table, &result ]( const auto&... fields )
+        {
+            return ( true && ... && read_field( l, table, result, fields ) );
+        }, easy_lua_reflect<T>::fields );
+        if( valid ) {
+            value = std::move( result );
+        }
+        return valid;
+    }
+
+    static T get(
+        lua_State*    l,
+        const int32_t stackpos )
+    {
+        T result{};
+        if( lua_istable( l, stackpos ) ) {
+            const auto table = easy_lua_absolute( l, stackpos );
+            std::apply( [ l, table, &result ]( const auto&... fields )
+            {
+                ( read_field( l, table, result, fields ), ... );
+            }, easy_lua_reflect<T>::fields );
+        }
+        return result;
+    }
+
+    static int32_t push(
+        lua_State* l,
+        const T&   value )
+    {
+        luaL_checkstack( l, 3, "table nesting too deep" );
+        lua_createtable( l, 0, static_cast<int32_t>( std::tuple_size_v<std::decay_t<decltype( easy_lua_reflect<T>::fields )>> ) );
+        std::apply( [ l, &value ]( const auto&... fields )
+        {
+            ( push_field( l, value, fields ), ... );
+        }, easy_lua_reflect<T>::fields );
+        return 1;
+    }
+
+private:
+    template<typename M>
+    static bool read_field(
+        lua_State*                        l,
+        const int32_t                     table,
+        T&                                value,
+        const easy_lua_field_info<T, M>& field )
+    {
+        lua_getfield( l, table, field.name );
+        const auto valid = lua_isnil( l, -1 ) || easy_lua_read( l, -1, value.*field.member );
+        lua_pop( l, 1 );
+        return valid;
+    }
+
+    template<typename M>
+    static void push_field(
+        lua_State*                        l,
+        const T&                          value,
+        const easy_lua_field_info<T, M>& field )
+    {
+        easy_lua_stack<M>::push( l, value.*field.member );
+        lua_setfield( l, -2, field.name );
+    }
+};
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>   Deduces the result and argument types of a callable. </summary>
+///-------------------------------------------------------------------------------------------------
+template<typename F>
+struct easy_lua_callable
+    : easy_lua_callable<decltype( &F::operator() )>
+{
+};
+
+template<typename R, typename... Args>
+struct easy_lua_callable<R( * )( Args... )>
+{
+    using result    = R;
+    using arguments = std::tuple<Args...>;
+};
+
+template<typename R, typename... Args>
+struct easy_lua_callable<R( * )( Args... ) noexcept>
+    : easy_lua_callable<R( * )( Args... )>
+{
+};
+
+template<typename R, typename C, typename... Args>
+struct easy_lua_callable<R( C::* )( Args... )>
+    : easy_lua_callable<R( * )( Args... )>
+{
+};
+
+template<typename R, typename C, typename... Args>
+struct easy_lua_callable<R( C::* )( Args... ) const>
+    : easy_lua_callable<R( * )( Args... )>
+{
+};
+
+template<typename R, typename C, typename... Args>
+struct easy_lua_callable<R( C::* )( Args... ) noexcept>
+    : easy_lua_callable<R( * )( Args... )>
+{
+};
+
+template<typename R, typename C, typename... Args>
+struct easy_lua_callable<R( C::* )( Args... ) const noexcept>
+    : easy_lua_callable<R( * )( Args... )>
+{
+};
+
+///-------------------------------------------------------------------------------------------------
+/// <summary>
+/// Generated glue between the lua stack and a typed callable. The arity and every argument type
+/// are validated in a single folded expression before any conversion happens; the per argument
+/// diagnostics only run once that check failed.
+/// </summary>
+///-------------------------------------------------------------------------------------------------
+template<typename R, typename... Args>
+struct easy_lua_invoker
+{
+    template<size_t... I>
+    static bool check(
+        lua_State*    l,
+        const int32_t first,
+        std::index_sequence<I...> )
+    {
+        return lua_gettop( l ) >= first - 1 + static_cast<int32_t>( sizeof...( Args ) )
+            && ( true && ... && easy_lua_stack<std::decay_t<Args>>::check( l, first + static_cast<int32_t>( I ) ) );
+    }
+
+    template<size_t... I>
+    static int32_t argument_error(
+        lua_State*    l,
+        const int32_t first,
+        std::index_sequence<I...> )
+    {
+        const char* names[] = { easy_lua_stack<std::decay_t<Args>>::name..., nullptr };
+        const bool  valid[] = { easy_lua_stack<std::decay_t<Args>>::check( l, first + static_cast<int32_t>( I ) )..., true };
+        for( size_t i = 0; i < sizeof...( Args ); ++i ) {
+            if( !valid[ i ] ) {
+                return luaL_typerror( l, first + static_cast<int32_t>( i ), names[ i ] );
+            }
+        }
+        return luaL_error( l, "expected %d arguments, got %d", static_cast<int32_t>( sizeof...( Args ) ), lua_gettop( l ) - first + 1 );
+    }
+
+    template<typename F, size_t... I>
+    static int32_t call(
+        lua_State*    l,
+        F&            callback,
+        const int32_t first,
+        std::index_sequence<I...> )
+    {
+        if constexpr( std::is_void_v<R> ) {
+            callback( easy_lua_stack<std::decay_t<Args>>::get( l, first + static_cast<int32_t>( I ) )... );
+            return 0;
+        }
+        else {
+            return easy_lua_stack<std::decay_t<R>>::push(
+                l,
+                callback( easy_lua_stack<std::decay_t<Args>>::get( l, first + static_cast<int32_t>( I ) )... )
+            );
+        }
+    }
+
+    template<typename F>
+    static int32_t invoke(
+        lua_State*    l,
+        F&            callback,
+        const int32_t first = 1 )
+    {
+        constexpr auto indices = std::index_sequence_for<Args...>();
+        if( !check( l, first, indices ) ) {
+            return argument_error( l, first, indices );
+        }
+        return call( l, callback, first, indices );
+    }
+};
+
+template<typename F, typename = typename easy_lua_callable<F>::arguments>
+struct easy_lua_function;
+
+template<typename F, typename... Args>
+struct easy_lua_function<F, std::tuple<Args...>>
+{
+    using invoker = easy_lua_invoker<typename easy_lua_callable<F>::result, Args...>;
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   The lua_CFunction, upvalue 1 holds the callable. </summary>
+    ///-------------------------------------------------------------------------------------------------
+    static int closure(
+        lua_State* l )
+    {
+        return invoker::invoke( l, *static_cast<F*>( lua_touserdata( l, lua_upvalueindex( 1 ) ) ) );
+    }
+
+    static int destroy(
+        lua_State* l )
+    {
+        static_cast<F*>( lua_touserdata( l, 1 ) )->~F();
+        return 0;
+    }
+
+    ///-------------------------------------------------------------------------------------------------
+    /// <summary>   Pushes a closure owning a copy of the callable. </summary>
+    ///-------------------------------------------------------------------------------------------------
+    template<typename U>
+    static void push(
+        lua_State* l,
+        U&&        callback )
+    {
+        static_assert( alignof( F ) <= 8, "The callable is over-aligned for lua userdata" );
+        new( lua_newuserdata( l, sizeof( F ) ) ) F( std::forward<U>( callback ) );
+        if constexpr( !std::is_trivially_destructible_v<F> ) {
+            static char metatable_key = 0;
+            lua_pushlightuserdata( l, &metatable_key );
+            lua_rawget( l, LUA_REGISTRYINDEX );
+            if( lua_isnil( l, -1 ) ) {
+                lua_pop( l, 1 );
+                lua_createtable( l, 0, 1 );
+                lua_pushcfunction( l, &destroy );
+                lua_setfield( l, -2, "__gc" );
+                lua_pushlightuserdata( l, &metatable_key );
+                lua_pushvalue( l, -2 );
+                lua_rawset( l, LUA_REGISTRYINDEX );
+            }
+            lua_setmetatable( l, -2 );
+        }
+        lua_pushcclosure( l, &closure, 1 );
+    }
+};
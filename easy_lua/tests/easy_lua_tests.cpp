@@ -0,0 +1,291 @@
+#include "easy_lua.hpp"
+#include "easy_lua_buffer.hpp"
+#include "easy_lua_function_ref.hpp"
+#include "easy_lua_pool.hpp"
+#include "easy_lua_reload.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    int32_t failures = 0;
+
+    void check(
+        const bool  condition,
+        const char* expression,
+        const char* file,
+        const int   line )
+    {
+        if( !condition ) {
+            printf( "%s:%d: check failed: %s\n", file, line, expression );
+            ++failures;
+        }
+    }
+
+#define EASY_LUA_CHECK( expression ) check( ( expression ), #expression, __FILE__, __LINE__ )
+
+    struct TestObject
+    {
+        int32_t value = 42;
+    };
+
+    EASY_LUA_CREATE_METATABLE_DATA( TestObject );
+
+    /// A directory of script files, removed with the object.
+    class ScriptDirectory
+    {
+    public:
+        explicit ScriptDirectory(
+            const char* name )
+            : m_path( std::filesystem::temp_directory_path() / name )
+        {
+            std::filesystem::remove_all( m_path );
+            std::filesystem::create_directories( m_path );
+        }
+
+        ~ScriptDirectory()
+        {
+            std::error_code ec;
+            std::filesystem::remove_all( m_path, ec );
+        }
+
+        /// Writes 'file' and moves its last write time past the previous one, file systems with a
+        /// coarse timestamp resolution would otherwise hide quick successive writes.
+        void write(
+            const char* file,
+            const char* source ) const
+        {
+            const auto path = m_path / file;
+            std::error_code ec;
+            const auto previous = std::filesystem::last_write_time( path, ec );
+            {
+                std::ofstream stream( path, std::ios::trunc );
+                stream << source;
+            }
+            if( !ec ) {
+                std::filesystem::last_write_time( path, previous + std::chrono::seconds( 1 ), ec );
+            }
+        }
+
+        std::string path() const
+        {
+            return m_path.string();
+        }
+
+    private:
+        std::filesystem::path m_path;
+    };
+
+    void test_pool_restore()
+    {
+        easy_lua_pool pool( 1, "", []( easy_lua* lua )
+        {
+            return lua->execute( "base = 1 settings = { x = 1 }", true );
+        } );
+        {
+            auto lua = pool.acquire();
+            EASY_LUA_CHECK( static_cast<bool>( lua ) );
+            if( !lua ) {
+                return;
+            }
+            EASY_LUA_CHECK( lua->execute( "base = 2 leaked = true settings.x = 2 settings.y = 3 string.leaked = 1", true ) );
+        }
+        EASY_LUA_CHECK( pool.available() == 1 );
+
+        auto lua = pool.acquire();
+        EASY_LUA_CHECK( static_cast<bool>( lua ) );
+        if( lua ) {
+            EASY_LUA_CHECK( lua->execute( "assert( base == 1 and leaked == nil )", true ) );
+            EASY_LUA_CHECK( lua->execute( "assert( settings.x == 1 and settings.y == nil )", true ) );
+            EASY_LUA_CHECK( lua->execute( "assert( string.leaked == nil )", true ) );
+        }
+    }
+
+    void test_function_ref_close()
+    {
+        auto lua = easy_lua::initialize( "" );
+        EASY_LUA_CHECK( lua != nullptr );
+        if( !lua ) {
+            return;
+        }
+        EASY_LUA_CHECK( lua->execute( "function add( a, b ) return a + b end", true ) );
+
+        easy_lua_function_ref<double( double, double )> add( lua, "add" );
+        EASY_LUA_CHECK( add.valid() );
+        const auto sum = add( 1.0, 2.0 );
+        EASY_LUA_CHECK( sum && sum.value == 3.0 );
+
+        easy_lua::close( &lua );
+        EASY_LUA_CHECK( !add.valid() );
+        EASY_LUA_CHECK( add( 1.0, 2.0 ).state == easy_lua::State_Runtime );
+        /// The destructor must not touch the closed state.
+    }
+
+    void test_buffer_expiry()
+    {
+        auto lua = easy_lua::initialize( "" );
+        EASY_LUA_CHECK( lua != nullptr );
+        if( !lua ) {
+            return;
+        }
+
+        const uint8_t          data[ 4 ] = { 1, 2, 3, 4 };
+        easy_lua_buffer::Owner owner;
+        easy_lua_buffer::push( lua, data, sizeof( data ), owner );
+        lua->set_global( "buf" );
+        EASY_LUA_CHECK( lua->execute( "assert( #buf == 4 and buf[ 1 ] == 1 and buf[ 4 ] == 4 )", true ) );
+        EASY_LUA_CHECK( lua->execute( "view = buf:sub( 2, 3 ) assert( #view == 2 and view[ 1 ] == 2 )", true ) );
+
+        owner.reset();
+        EASY_LUA_CHECK( lua->execute( "assert( not buf:valid() and not view:valid() )", true ) );
+        EASY_LUA_CHECK( !lua->execute( "return buf[ 1 ]", true ) );
+        EASY_LUA_CHECK( !lua->execute( "return view:tostring()", true ) );
+
+        size_t size = 0;
+        lua->get_global( "buf" );
+        EASY_LUA_CHECK( easy_lua_buffer::get( lua, -1, size ) == nullptr );
+        lua->pop( 1 );
+        easy_lua::close( &lua );
+    }
+
+    void test_budget()
+    {
+        auto lua = easy_lua::initialize( "" );
+        EASY_LUA_CHECK( lua != nullptr );
+        if( !lua ) {
+            return;
+        }
+
+        easy_lua::Budget instructions;
+        instructions.instructions = 100000;
+        EASY_LUA_CHECK( lua->execute( "local x = 0 for i = 1, 10 do x = x + i end", instructions, true ) == easy_lua::State_Success );
+        EASY_LUA_CHECK( lua->execute( "while true do end", instructions, true ) == easy_lua::State_Budget );
+        /// Catching the error inside the script does not extend the budget.
+        EASY_LUA_CHECK( lua->execute( "while true do pcall( function() while true do end end ) end", instructions, true ) == easy_lua::State_Budget );
+
+        easy_lua::Budget time;
+        time.time = std::chrono::milliseconds( 20 );
+        EASY_LUA_CHECK( lua->execute( "local x = 0 while true do x = x + 1 end", time, true ) == easy_lua::State_Budget );
+
+        /// Nested budgets, exceeding the outer budget inside the inner call fails both.
+        lua->export_function( "run_budgeted", []( easy_lua* l ) -> int32_t
+        {
+            easy_lua::Budget inner;
+            inner.instructions = 1000000000;
+            l->push_bool( l->execute( "while true do end", inner, true ) == easy_lua::State_Budget );
+            return 1;
+        } );
+        EASY_LUA_CHECK( lua->execute( "inner_exceeded = run_budgeted() while true do end", instructions, true ) == easy_lua::State_Budget );
+        EASY_LUA_CHECK( lua->execute( "assert( inner_exceeded == true )", true ) );
+
+        /// The state stays usable and the hook is removed afterwards.
+        EASY_LUA_CHECK( lua->execute( "local x = 0 for i = 1, 1000000 do x = x + i end", true ) );
+        easy_lua::close( &lua );
+    }
+
+    void test_reload()
+    {
+        const ScriptDirectory directory( "easy_lua_tests_reload" );
+        directory.write( "config.lua", "value = 1" );
+        directory.write( "main.lua", "include( 'config.lua' ) main_loads = ( main_loads or 0 ) + 1" );
+
+        auto lua = easy_lua::initialize( directory.path() );
+        EASY_LUA_CHECK( lua != nullptr );
+        if( !lua ) {
+            return;
+        }
+        {
+            easy_lua_reload::Options options;
+            options.poll_interval = std::chrono::milliseconds( 0 );
+            options.use_inotify   = false;
+            easy_lua_reload reload( lua, options );
+
+            EASY_LUA_CHECK( reload.execute( "main.lua" ) );
+            EASY_LUA_CHECK( reload.modules().size() == 2 );
+            EASY_LUA_CHECK( reload.dependents( "config.lua" ).size() == 1 );
+            EASY_LUA_CHECK( lua->execute( "assert( value == 1 and main_loads == 1 )", true ) );
+            EASY_LUA_CHECK( reload.poll().empty() );
+
+            /// Only the changed module runs again, the module including it keeps its globals.
+            directory.write( "config.lua", "value = 2" );
+            const auto changes = reload.poll();
+            EASY_LUA_CHECK( changes.size() == 1 && changes.front().success );
+            EASY_LUA_CHECK( lua->execute( "assert( value == 2 and main_loads == 1 )", true ) );
+
+            /// Touching a file without changing it does not re-execute it.
+            directory.write( "config.lua", "value = 2" );
+            EASY_LUA_CHECK( reload.poll().empty() );
+
+            /// A failing module reports its error.
+            directory.write( "config.lua", "value = 3 error( 'broken' )" );
+            const auto failed = reload.poll();
+            EASY_LUA_CHECK( failed.size() == 1 && !failed.front().success && !failed.front().error.empty() );
+
+            const auto forced = reload.reload( "main.lua" );
+            EASY_LUA_CHECK( forced.size() == 1 && forced.front().success );
+            EASY_LUA_CHECK( lua->execute( "assert( main_loads == 2 )", true ) );
+        }
+        easy_lua::close( &lua );
+    }
+
+    void test_userdata_unterminated_name()
+    {
+        auto lua = easy_lua::initialize( "" );
+        EASY_LUA_CHECK( lua != nullptr );
+        if( !lua ) {
+            return;
+        }
+        lua->export_class( lua_TestObject, { { "noop", []( easy_lua* ) -> int32_t { return 0; } } } );
+        TestObject object;
+
+        /// A view into a longer string is not NUL terminated, the lookups must stop at its end.
+        const auto       padded = std::string( lua_TestObject[ 1 ] ) + "_padding";
+        std::string_view unterminated( padded.data(), lua_TestObject[ 1 ].size() );
+        lua->push_userdata( unterminated, &object );
+        EASY_LUA_CHECK( lua->get_userdata<TestObject>( -1, unterminated, true ) == &object );
+        lua->push_userdata( lua_TestObject, &object );
+        EASY_LUA_CHECK( lua->get_userdata<TestObject>( -1, unterminated, true ) == &object );
+        easy_lua::close( &lua );
+    }
+
+    struct Test
+    {
+        const char* name;
+        void( *run )();
+    };
+
+    constexpr Test tests[] = {
+        { "pool_restore", &test_pool_restore },
+        { "function_ref_close", &test_function_ref_close },
+        { "buffer_expiry", &test_buffer_expiry },
+        { "budget", &test_budget },
+        { "reload", &test_reload },
+        { "userdata_unterminated_name", &test_userdata_unterminated_name },
+    };
+}
+
+/// easy_lua_tests [name], runs every test without a name.
+int main(
+    const int argc,
+    char**    argv )
+{
+    const char* filter = argc > 1 ? argv[ 1 ] : nullptr;
+    auto        ran    = false;
+    for( const auto& test : tests ) {
+        if( filter && std::strcmp( filter, test.name ) != 0 ) {
+            continue;
+        }
+        const auto before = failures;
+        test.run();
+        printf( "%-32s %s\n", test.name, failures == before ? "passed" : "FAILED" );
+        ran = true;
+    }
+    if( !ran ) {
+        printf( "unknown test: %s\n", filter );
+        return EXIT_FAILURE;
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}